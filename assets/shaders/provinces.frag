@@ -1,10 +1,12 @@
-uniform sampler2D texture;
+// Index of the color of each pixel in the provinces image, in the red
+// (low byte) and green (high byte) channels.
 uniform sampler2D provincesTexture;
-uniform sampler2D baronyTexture;
-uniform sampler2D countyTexture;
-uniform sampler2D duchyTexture;
-uniform sampler2D kingdomTexture;
-uniform sampler2D empireTexture;
+// Lookup tables with the color of each index for each map mode,
+// and the id of its title for each tier, with one block of rows
+// per map mode or tier and 256 indices per row.
+uniform sampler2D colorsTexture;
+uniform sampler2D titlesTexture;
+uniform float lookupRows;
 uniform vec2 textureSize;
 
 uniform float time;
@@ -34,53 +36,63 @@ bool IsSelected(int type, vec4 color) {
     return false;
 }
 
-bool IsBorder(sampler2D tex) {
+float GetIndex(vec2 coords) {
+    vec4 texel = texture2D(provincesTexture, coords);
+    return floor(texel.r * 255.0 + 0.5) + floor(texel.g * 255.0 + 0.5) * 256.0;
+}
+
+vec4 Lookup(sampler2D table, float blocks, float block, float index) {
+    vec2 entry = vec2(mod(index, 256.0), floor(index / 256.0) + block * lookupRows);
+    return texture2D(table, (entry + 0.5) / vec2(256.0, blocks * lookupRows));
+}
+
+vec4 GetEntityColor(int type) {
+    return Lookup(colorsTexture, 6.0, float(type), GetIndex(gl_TexCoord[0].xy));
+}
+
+// The index for provinces, and the id of the title for the other tiers.
+vec4 GetEntity(int type, vec2 coords) {
+    float index = GetIndex(coords);
+    if(type == PROVINCE)
+        return vec4(index);
+    return Lookup(titlesTexture, 5.0, float(type - BARONY), index);
+}
+
+bool IsBorder(int type) {
     // Calculate the texel size based on the texture dimensions
     vec2 texelSize = 1.0 / textureSize;
 
     // Sample the current pixel and its neighbors
-    vec4 currentColor = texture2D(tex, gl_TexCoord[0].xy);
-    vec4 leftColor = texture2D(tex, gl_TexCoord[0].xy + vec2(-texelSize.x, 0.0));
-    vec4 rightColor = texture2D(tex, gl_TexCoord[0].xy + vec2(texelSize.x, 0.0));
-    vec4 topColor = texture2D(tex, gl_TexCoord[0].xy + vec2(0.0, texelSize.y));
-    vec4 bottomColor = texture2D(tex, gl_TexCoord[0].xy + vec2(0.0, -texelSize.y));
+    vec4 current = GetEntity(type, gl_TexCoord[0].xy);
+    vec4 left = GetEntity(type, gl_TexCoord[0].xy + vec2(-texelSize.x, 0.0));
+    vec4 right = GetEntity(type, gl_TexCoord[0].xy + vec2(texelSize.x, 0.0));
+    vec4 top = GetEntity(type, gl_TexCoord[0].xy + vec2(0.0, texelSize.y));
+    vec4 bottom = GetEntity(type, gl_TexCoord[0].xy + vec2(0.0, -texelSize.y));
 
     // Check if the current pixel differs from any of its neighbors
-    return currentColor != leftColor
-        || currentColor != rightColor
-        || currentColor != topColor
-        || currentColor != bottomColor;
-    
-    // return currentColor != rightColor || currentColor != bottomColor;
-}
-
-vec4 GetEntityColor(int type) {
-    if(type == PROVINCE) return texture2D(provincesTexture, gl_TexCoord[0].xy);
-    if(type == BARONY) return texture2D(baronyTexture, gl_TexCoord[0].xy);
-    if(type == COUNTY) return texture2D(countyTexture, gl_TexCoord[0].xy);
-    if(type == DUCHY) return texture2D(duchyTexture, gl_TexCoord[0].xy);
-    if(type == KINGDOM) return texture2D(kingdomTexture, gl_TexCoord[0].xy);
-    if(type == EMPIRE) return texture2D(empireTexture, gl_TexCoord[0].xy);
-    return vec4(0.0, 0.0, 0.0, 1.0);
+    return current != left
+        || current != right
+        || current != top
+        || current != bottom;
 }
 
 int GetBorderTier() {
     // Check if it is the border of a province first to avoid unless calculation for highter tier.
-    if(!IsBorder(provincesTexture)) return -1;
-    if(mapMode >= 10 && IsBorder(empireTexture)) return 5;
-    if(mapMode >= 9 && IsBorder(kingdomTexture)) return 4;
-    if(mapMode >= 8 && IsBorder(duchyTexture)) return 3;
-    if(mapMode >= 7 && IsBorder(countyTexture)) return 2;
-    if(mapMode >= 6 && IsBorder(baronyTexture)) return 1;
+    if(!IsBorder(PROVINCE)) return -1;
+    if(mapMode >= 10 && IsBorder(EMPIRE)) return 5;
+    if(mapMode >= 9 && IsBorder(KINGDOM)) return 4;
+    if(mapMode >= 8 && IsBorder(DUCHY)) return 3;
+    if(mapMode >= 7 && IsBorder(COUNTY)) return 2;
+    if(mapMode >= 6 && IsBorder(BARONY)) return 1;
     return 0;
 }
 
 void main() {
-    vec4 pixelColor = texture2D(texture, gl_TexCoord[0].xy);
-    vec4 provincePixelColor = texture2D(provincesTexture, gl_TexCoord[0].xy);
+    // Map modes of titles start after the other map modes.
+    int type = (mapMode >= 6) ? mapMode - 5 : PROVINCE;
 
     // Final color that will be used for the pixel.
-    vec4 color = gl_Color * pixelColor;
+    vec4 color = gl_Color * GetEntityColor(type);
 
     for(int i = EMPIRE; i >= PROVINCE; i--) {
         bool isSelected = IsSelected(i, GetEntityColor(i));
@@ -0,0 +1,164 @@
+#include "Corpus.hpp"
+
+#include <filesystem>
+
+std::size_t Corpus::Input::GetSize() const {
+    std::size_t size = 0;
+    for(const std::string& file : files)
+        size += file.size();
+    return size;
+}
+
+// The output of mt19937 is the same on every platform,
+// unlike that of the standard distributions.
+static uint32_t Random(std::mt19937& rng, uint32_t max) {
+    return rng() % max;
+}
+
+static std::string RandomName(std::mt19937& rng) {
+    static const char* syllables[] = { "ar", "bel", "cor", "dun", "el", "fal", "gar", "har", "is", "jor", "kel", "lor", "mar", "nor", "or", "pen", "rin", "sal", "tor", "val", "wyn" };
+    std::string name;
+    uint32_t count = 2 + Random(rng, 3);
+    for(uint32_t i = 0; i < count; i++)
+        name += syllables[Random(rng, std::size(syllables))];
+    return name;
+}
+
+static std::string RandomColor(std::mt19937& rng) {
+    return fmt::format("{{ {} {} {} }}", Random(rng, 256), Random(rng, 256), Random(rng, 256));
+}
+
+// Titles nested as in common/landed_titles, with colors, capitals and cultural names.
+static Corpus::Input GenerateTitles(std::mt19937& rng) {
+    std::string content;
+    int provinceId = 1;
+
+    for(int k = 0; k < 40; k++) {
+        content += fmt::format("k_{}_{} = {{\n\tcolor = {}\n\tcapital = c_{}_0\n", RandomName(rng), k, RandomColor(rng), k);
+        for(int d = 0; d < 6; d++) {
+            content += fmt::format("\td_{}_{}_{} = {{\n\t\tcolor = {}\n\t\tcapital = c_{}_{}\n", RandomName(rng), k, d, RandomColor(rng), k, d);
+            for(int c = 0; c < 5; c++) {
+                content += fmt::format("\t\tc_{}_{}_{}_{} = {{\n\t\t\tcolor = {}\n", RandomName(rng), k, d, c, RandomColor(rng));
+                content += fmt::format("\t\t\tcultural_names = {{\n\t\t\t\tname_list_{} = cn_{}\n\t\t\t}}\n", RandomName(rng), RandomName(rng));
+                for(int b = 0; b < 5; b++, provinceId++)
+                    content += fmt::format("\t\t\tb_{}_{} = {{\n\t\t\t\tprovince = {}\n\t\t\t\tcolor = {}\n\t\t\t}}\n", RandomName(rng), provinceId, provinceId, RandomColor(rng));
+                content += "\t\t}\n";
+            }
+            content += "\t}\n";
+        }
+        content += "}\n";
+    }
+    return Corpus::Input{"landed_titles", {std::move(content)}};
+}
+
+// Province entries as in history/provinces, with dated changes.
+static Corpus::Input GenerateProvincesHistory(std::mt19937& rng) {
+    static const char* holdings[] = { "castle_holding", "city_holding", "church_holding", "tribal_holding", "none" };
+    std::string content;
+
+    for(int id = 1; id <= 20000; id++) {
+        content += fmt::format("# {}\n{} = {{\n\tculture = {}\n\treligion = {}\n\tholding = {}\n", RandomName(rng), id, RandomName(rng), RandomName(rng), holdings[Random(rng, std::size(holdings))]);
+        if(Random(rng, 4) == 0)
+            content += fmt::format("\t{}.{}.{} = {{\n\t\tholding = {}\n\t}}\n", 800 + Random(rng, 400), 1 + Random(rng, 12), 1 + Random(rng, 28), holdings[Random(rng, std::size(holdings))]);
+        content += "}\n";
+    }
+    return Corpus::Input{"provinces_history", {std::move(content)}};
+}
+
+static Corpus::Input GenerateDeepNesting(std::mt19937& rng) {
+    std::string content;
+
+    for(int i = 0; i < 2000; i++) {
+        int depth = 32 + Random(rng, 96);
+        for(int d = 0; d < depth; d++)
+            content += fmt::format("{}{} = {{ value = {}\n", std::string(d, '\t'), RandomName(rng), Random(rng, 1000));
+        for(int d = depth - 1; d >= 0; d--)
+            content += std::string(d, '\t') + "}\n";
+    }
+    return Corpus::Input{"deep_nesting", {std::move(content)}};
+}
+
+// Long lists of numbers, as in map_data/default.map and the terrain files.
+static Corpus::Input GenerateNumericLists(std::mt19937& rng) {
+    std::string content;
+    int id = 1;
+
+    for(int i = 0; i < 200; i++) {
+        std::string list;
+        for(int j = 0; j < 5000; j++) {
+            id += 1 + Random(rng, 3);
+            list += fmt::format(" {}", id);
+        }
+        content += fmt::format("list_{} = {{{} }}\n", i, list);
+        content += fmt::format("range_{} = RANGE {{ {} {} }}\n", i, id, id + Random(rng, 500));
+        content += fmt::format("weights_{} = {{ {:.3f} {:.3f} {:.3f} }}\n", i, Random(rng, 1000) / 7.0, Random(rng, 1000) / 7.0, Random(rng, 1000) / 7.0);
+    }
+    return Corpus::Input{"numeric_lists", {std::move(content)}};
+}
+
+// Small entries separated by blocks of comments, as in the documented files of the game.
+static Corpus::Input GenerateComments(std::mt19937& rng) {
+    std::string content;
+
+    for(int i = 0; i < 5000; i++) {
+        for(int line = 0; line < 20; line++) {
+            content += "#";
+            for(uint32_t w = 0, words = 4 + Random(rng, 12); w < words; w++)
+                content += " " + RandomName(rng);
+            content += "\n";
+        }
+        content += fmt::format("entry_{} = {{ key = {} }} # {}\n", i, RandomName(rng), RandomName(rng));
+    }
+    return Corpus::Input{"comments", {std::move(content)}};
+}
+
+// Many small files, as in history/titles or common/culture.
+static Corpus::Input GenerateSmallFiles(std::mt19937& rng) {
+    Corpus::Input input{"small_files", {}};
+
+    for(int i = 0; i < 3000; i++) {
+        std::string content;
+        for(int j = 0, count = 1 + Random(rng, 5); j < count; j++) {
+            content += fmt::format("c_{} = {{\n\t{}.1.1 = {{\n\t\tholder = {}\n\t\tliege = \"k_{}\"\n\t}}\n}}\n",
+                RandomName(rng), 900 + Random(rng, 300), Random(rng, 100000), RandomName(rng));
+        }
+        input.files.push_back(std::move(content));
+    }
+    return input;
+}
+
+std::vector<Corpus::Input> Corpus::Generate() {
+    std::mt19937 rng(1066);
+    std::vector<Input> inputs;
+    inputs.push_back(GenerateTitles(rng));
+    inputs.push_back(GenerateProvincesHistory(rng));
+    inputs.push_back(GenerateDeepNesting(rng));
+    inputs.push_back(GenerateNumericLists(rng));
+    inputs.push_back(GenerateComments(rng));
+    inputs.push_back(GenerateSmallFiles(rng));
+    return inputs;
+}
+
+Corpus::Input Corpus::Load(const std::string& path) {
+    Input input{path, {}};
+    std::vector<std::string> filesPath;
+
+    if(std::filesystem::is_directory(path)) {
+        for(const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+            if(entry.is_regular_file() && entry.path().extension() == ".txt")
+                filesPath.push_back(entry.path());
+        }
+        std::sort(filesPath.begin(), filesPath.end());
+    }
+    else {
+        filesPath.push_back(path);
+    }
+
+    for(const std::string& filePath : filesPath) {
+        std::ifstream file(filePath, std::ios::binary);
+        if(!file)
+            throw std::runtime_error(fmt::format("error: failed to read benchmark input '{}'.", filePath));
+        input.files.push_back(File::ReadString(file));
+    }
+    return input;
+}
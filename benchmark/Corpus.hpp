@@ -0,0 +1,17 @@
+#pragma once
+
+// Inputs of the benchmark, each made of one or more file contents.
+namespace Corpus {
+    struct Input {
+        std::string name;
+        std::vector<std::string> files;
+
+        std::size_t GetSize() const;
+    };
+
+    // Inputs shaped like the files of a mod, generated with a fixed seed
+    // so that their content is the same from one run to another.
+    std::vector<Input> Generate();
+    // Read a file, or all the .txt files of a directory and its subdirectories.
+    Input Load(const std::string& path);
+}
@@ -0,0 +1,86 @@
+#include "Memory.hpp"
+
+#include <atomic>
+#include <new>
+#include <sys/resource.h>
+
+static std::atomic<uint64_t> s_AllocationsCount = 0;
+static std::atomic<uint64_t> s_AllocatedBytes = 0;
+
+static void* Allocate(std::size_t size, std::size_t alignment) {
+    s_AllocationsCount.fetch_add(1, std::memory_order_relaxed);
+    s_AllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+    if(size == 0)
+        size = 1;
+    void* memory = (alignment <= alignof(std::max_align_t))
+        ? std::malloc(size)
+        : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    return memory;
+}
+
+void* operator new(std::size_t size) {
+    void* memory = Allocate(size, alignof(std::max_align_t));
+    if(memory == nullptr)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    void* memory = Allocate(size, (std::size_t) alignment);
+    if(memory == nullptr)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return Allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return Allocate(size, alignof(std::max_align_t));
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+
+Memory::Allocations Memory::GetAllocations() {
+    return Allocations{
+        s_AllocationsCount.load(std::memory_order_relaxed),
+        s_AllocatedBytes.load(std::memory_order_relaxed)
+    };
+}
+
+void Memory::ResetPeak() {
+    // Writing 5 to clear_refs resets the peak resident set size (Linux 4.0+).
+    std::ofstream file("/proc/self/clear_refs");
+    file << "5";
+}
+
+uint64_t Memory::GetPeak() {
+    std::ifstream file("/proc/self/status");
+    std::string line;
+    while(std::getline(file, line)) {
+        if(line.starts_with("VmHWM:"))
+            return std::stoull(line.substr(6)) * 1024;
+    }
+
+    // Without procfs, fall back to the peak of the whole process.
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (uint64_t) usage.ru_maxrss * 1024;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+namespace Memory {
+    // Allocations made through the global operator new, which
+    // is replaced in the benchmark executable only.
+    struct Allocations {
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+    };
+
+    Allocations GetAllocations();
+
+    // Reset the peak resident memory to the current one, if the system allows it.
+    void ResetPeak();
+    // Peak resident memory of the process, in bytes.
+    uint64_t GetPeak();
+}
@@ -0,0 +1,187 @@
+#include "Corpus.hpp"
+#include "Memory.hpp"
+#include "parser/Parser.hpp"
+#include "parser/Writer.hpp"
+
+#include <chrono>
+
+// Run the lexer, the parser and the writer on each input of the corpus
+// and print the results as JSON, so that they can be compared between
+// versions. Usage: meckt-benchmark [--repeat N] [file or directory...]
+// Files and directories given are benchmarked after the generated inputs.
+
+struct Result {
+    std::string operation;
+    std::vector<double> times;
+    std::size_t bytes = 0;
+    std::size_t tokens = 0;
+    Memory::Allocations allocations;
+    uint64_t peakMemory = 0;
+    bool identical = true;
+
+    double GetMedian() const {
+        std::vector<double> sorted = times;
+        std::sort(sorted.begin(), sorted.end());
+        return sorted[sorted.size() / 2];
+    }
+};
+
+// Call prepare then run the given number of times, and only time run.
+// The allocations are those of a single run.
+template <typename P, typename R>
+static Result Measure(const std::string& operation, uint repeats, P prepare, R run) {
+    Result result{operation};
+    Memory::ResetPeak();
+
+    for(uint i = 0; i < repeats; i++) {
+        prepare();
+        Memory::Allocations before = Memory::GetAllocations();
+        auto start = std::chrono::steady_clock::now();
+        run();
+        auto end = std::chrono::steady_clock::now();
+        Memory::Allocations after = Memory::GetAllocations();
+
+        result.times.push_back(std::chrono::duration<double>(end - start).count());
+        result.allocations = Memory::Allocations{after.count - before.count, after.bytes - before.bytes};
+    }
+
+    result.peakMemory = Memory::GetPeak();
+    return result;
+}
+
+static std::vector<Result> RunInput(const Corpus::Input& input, uint repeats) {
+    std::vector<Result> results;
+    const std::vector<std::string>& files = input.files;
+    std::size_t size = input.GetSize();
+
+    std::vector<std::vector<Parser::CompactToken>> tokens(files.size());
+    std::vector<Parser::Node> nodes(files.size());
+    std::vector<std::string> outputs(files.size());
+    std::size_t tokensCount = 0;
+
+    // Lexing, which is done on several threads for big files.
+    Result lex = Measure("lex", repeats, [&]() {
+        for(auto& fileTokens : tokens)
+            std::vector<Parser::CompactToken>().swap(fileTokens);
+    }, [&]() {
+        for(std::size_t i = 0; i < files.size(); i++)
+            tokens[i] = Parser::LexCompact(files[i]);
+    });
+    for(const auto& fileTokens : tokens)
+        tokensCount += fileTokens.size();
+    lex.bytes = size;
+    lex.tokens = tokensCount;
+    results.push_back(std::move(lex));
+
+    // Parsing the tokens already lexed, each file in its own arena.
+    std::vector<std::vector<Parser::CompactToken>> tokensCopy(files.size());
+    Result parse = Measure("parse", repeats, [&]() {
+        nodes.assign(files.size(), Parser::Node());
+        tokensCopy = tokens;
+    }, [&]() {
+        for(std::size_t i = 0; i < files.size(); i++) {
+            Parser::Arena::Scope scope(new Parser::Arena(files[i].size()));
+            Parser::TokenStream stream(files[i], std::move(tokensCopy[i]));
+            nodes[i] = Parser::Parse(stream);
+        }
+    });
+    parse.bytes = size;
+    parse.tokens = tokensCount;
+    results.push_back(std::move(parse));
+
+    Result write = Measure("write", repeats, [&]() {}, [&]() {
+        for(std::size_t i = 0; i < files.size(); i++) {
+            Parser::Writer writer;
+            writer.Write(nodes[i]);
+            outputs[i] = writer.GetContent();
+        }
+    });
+    for(const std::string& output : outputs)
+        write.bytes += output.size();
+    results.push_back(std::move(write));
+
+    // Write the nodes and parse the output again, which must give the same nodes.
+    std::vector<uint64_t> hashes(files.size());
+    for(std::size_t i = 0; i < files.size(); i++)
+        hashes[i] = nodes[i].GetHash();
+    bool identical = true;
+
+    Result roundTrip = Measure("round_trip", repeats, [&]() {}, [&]() {
+        for(std::size_t i = 0; i < files.size(); i++) {
+            Parser::Writer writer;
+            writer.Write(nodes[i]);
+            std::string_view content = writer.GetContent();
+
+            Parser::Arena::Scope scope(new Parser::Arena(content.size()));
+            Parser::TokenStream stream(content);
+            Parser::Node node = Parser::Parse(stream);
+            identical &= (node.GetHash() == hashes[i]);
+        }
+    });
+    roundTrip.bytes = size;
+    roundTrip.identical = identical;
+    results.push_back(std::move(roundTrip));
+
+    return results;
+}
+
+static std::string ToJson(const Corpus::Input& input, const std::vector<Result>& results) {
+    std::vector<std::string> operations;
+    for(const Result& result : results) {
+        double median = result.GetMedian();
+        double min = *std::min_element(result.times.begin(), result.times.end());
+        operations.push_back(fmt::format(
+            "        {{\"operation\": \"{}\", \"median_seconds\": {:.6f}, \"min_seconds\": {:.6f}, "
+            "\"mb_per_second\": {:.2f}, \"tokens_per_second\": {:.0f}, \"allocations\": {}, "
+            "\"allocated_bytes\": {}, \"peak_rss_bytes\": {}, \"identical\": {}}}",
+            result.operation, median, min,
+            result.bytes / (1024.0 * 1024.0) / median, result.tokens / median,
+            result.allocations.count, result.allocations.bytes, result.peakMemory, result.identical
+        ));
+    }
+
+    std::string name;
+    for(char ch : input.name) {
+        if(ch == '"' || ch == '\\')
+            name += '\\';
+        name += ch;
+    }
+    return fmt::format(
+        "    {{\n      \"input\": \"{}\",\n      \"files\": {},\n      \"bytes\": {},\n      \"results\": [\n{}\n      ]\n    }}",
+        name, input.files.size(), input.GetSize(), fmt::join(operations, ",\n")
+    );
+}
+
+int main(int argc, char** argv) {
+    uint repeats = 5;
+    std::vector<std::string> paths;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if(arg == "--repeat" && i + 1 < argc)
+            repeats = std::max(1, std::stoi(argv[++i]));
+        else
+            paths.push_back(arg);
+    }
+
+    std::vector<Corpus::Input> inputs = Corpus::Generate();
+    for(const std::string& path : paths)
+        inputs.push_back(Corpus::Load(path));
+
+    // The summary goes to stderr so that stdout only holds the JSON.
+    std::vector<std::string> entries;
+    for(const Corpus::Input& input : inputs) {
+        std::vector<Result> results = RunInput(input, repeats);
+        for(const Result& result : results) {
+            double median = result.GetMedian();
+            fmt::println(stderr, "{:<24} {:<12} {:>10.3f} ms {:>10.2f} MB/s {:>12} allocs {:>8} MB peak{}",
+                input.name, result.operation, median * 1000.0, result.bytes / (1024.0 * 1024.0) / median,
+                result.allocations.count, result.peakMemory / (1024 * 1024), result.identical ? "" : "  (different)");
+        }
+        entries.push_back(ToJson(input, results));
+    }
+
+    fmt::println("{{\n  \"repeats\": {},\n  \"threads\": {},\n  \"inputs\": [\n{}\n  ]\n}}",
+        repeats, Parallel::GetThreadsCount(), fmt::join(entries, ",\n"));
+    return 0;
+}
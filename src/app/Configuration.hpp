@@ -24,6 +24,11 @@ public:
 
     //Graphics
     inline static sf::Vector2u windowResolution = {800, 600};
+
+    // Memory
+    // Drop the images of the map kept in memory once uploaded
+    // to the GPU, and read them again from the files when needed.
+    inline static bool lowMemory = false;
     
     // Resources
     inline static ResourceManager<sf::Texture, Textures> textures = ResourceManager<sf::Texture, Textures>("texture");
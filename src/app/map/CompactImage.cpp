@@ -0,0 +1,129 @@
+#include "CompactImage.hpp"
+
+////////////////////////////////
+//    GrayscaleImage class    //
+////////////////////////////////
+
+GrayscaleImage::GrayscaleImage()
+: m_Size(0, 0) {}
+
+bool GrayscaleImage::Load(const sf::Image& image) {
+    const sf::Uint8* pixels = image.getPixelsPtr();
+    m_Size = image.getSize();
+    m_Values.resize((std::size_t) m_Size.x * m_Size.y);
+    bool grayscale = true;
+
+    for(std::size_t i = 0; i < m_Values.size(); i++) {
+        const sf::Uint8* pixel = pixels + i * 4;
+        m_Values[i] = pixel[0];
+        grayscale &= (pixel[1] == pixel[0] && pixel[2] == pixel[0] && pixel[3] == 0xFF);
+    }
+    return grayscale;
+}
+
+void GrayscaleImage::Clear() {
+    m_Size = sf::Vector2u(0, 0);
+    std::vector<uint8_t>().swap(m_Values);
+}
+
+bool GrayscaleImage::IsEmpty() const {
+    return m_Values.empty();
+}
+
+sf::Vector2u GrayscaleImage::GetSize() const {
+    return m_Size;
+}
+
+uint8_t GrayscaleImage::GetValue(uint x, uint y) const {
+    return m_Values[(std::size_t) y * m_Size.x + x];
+}
+
+sf::Image GrayscaleImage::ToImage() const {
+    std::vector<sf::Uint8> pixels(m_Values.size() * 4);
+    for(std::size_t i = 0; i < m_Values.size(); i++) {
+        pixels[i * 4 + 0] = m_Values[i];
+        pixels[i * 4 + 1] = m_Values[i];
+        pixels[i * 4 + 2] = m_Values[i];
+        pixels[i * 4 + 3] = 0xFF;
+    }
+
+    sf::Image image;
+    image.create(m_Size.x, m_Size.y, pixels.data());
+    return image;
+}
+
+////////////////////////////////
+//     PaletteImage class     //
+////////////////////////////////
+
+PaletteImage::PaletteImage()
+: m_Size(0, 0) {}
+
+bool PaletteImage::Load(const sf::Image& image) {
+    const sf::Uint8* pixels = image.getPixelsPtr();
+    m_Size = image.getSize();
+    m_Indices.resize((std::size_t) m_Size.x * m_Size.y);
+    m_Palette.clear();
+
+    std::unordered_map<uint32_t, uint8_t> indices;
+    uint32_t previousColor = 0;
+    uint8_t index = 0;
+    bool complete = true;
+
+    for(std::size_t i = 0; i < m_Indices.size(); i++) {
+        sf::Color color(pixels[i * 4], pixels[i * 4 + 1], pixels[i * 4 + 2], pixels[i * 4 + 3]);
+
+        // The palette is only searched again when the color changes.
+        if(color.toInteger() != previousColor || i == 0) {
+            const auto& it = indices.find(color.toInteger());
+            if(it != indices.end()) {
+                index = it->second;
+            }
+            else if(m_Palette.size() < MaxColors) {
+                index = m_Palette.size();
+                indices[color.toInteger()] = index;
+                m_Palette.push_back(color);
+            }
+            else {
+                index = 0;
+                complete = false;
+            }
+            previousColor = color.toInteger();
+        }
+        m_Indices[i] = index;
+    }
+    return complete;
+}
+
+void PaletteImage::Clear() {
+    m_Size = sf::Vector2u(0, 0);
+    std::vector<sf::Color>().swap(m_Palette);
+    std::vector<uint8_t>().swap(m_Indices);
+}
+
+bool PaletteImage::IsEmpty() const {
+    return m_Indices.empty();
+}
+
+sf::Vector2u PaletteImage::GetSize() const {
+    return m_Size;
+}
+
+sf::Color PaletteImage::GetColor(uint x, uint y) const {
+    return m_Palette[m_Indices[(std::size_t) y * m_Size.x + x]];
+}
+
+sf::Image PaletteImage::ToImage() const {
+    std::vector<sf::Uint8> pixels(m_Indices.size() * 4);
+    for(std::size_t i = 0; i < m_Indices.size(); i++) {
+        const sf::Color& color = m_Palette[m_Indices[i]];
+        pixels[i * 4 + 0] = color.r;
+        pixels[i * 4 + 1] = color.g;
+        pixels[i * 4 + 2] = color.b;
+        pixels[i * 4 + 3] = color.a;
+    }
+
+    sf::Image image;
+    image.create(m_Size.x, m_Size.y, pixels.data());
+    return image;
+}
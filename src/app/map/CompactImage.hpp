@@ -0,0 +1,48 @@
+#pragma once
+
+// Images of the map kept in memory with less than the four bytes per
+// pixel of sf::Image, and converted back to RGBA to be uploaded.
+
+// Single channel image, such as the heightmap.
+class GrayscaleImage {
+public:
+    GrayscaleImage();
+
+    // Keep the red channel of the image. Return false if the other
+    // channels were different or the image wasn't opaque, since they are lost.
+    bool Load(const sf::Image& image);
+    void Clear();
+
+    bool IsEmpty() const;
+    sf::Vector2u GetSize() const;
+    uint8_t GetValue(uint x, uint y) const;
+    sf::Image ToImage() const;
+
+private:
+    sf::Vector2u m_Size;
+    std::vector<uint8_t> m_Values;
+};
+
+// Image with few colors, such as the rivers, kept as
+// the index of the color of each pixel in a palette.
+class PaletteImage {
+public:
+    static constexpr std::size_t MaxColors = 256;
+
+    PaletteImage();
+
+    // Return false if the image has more than MaxColors colors,
+    // in which case the other colors are replaced by the first one.
+    bool Load(const sf::Image& image);
+    void Clear();
+
+    bool IsEmpty() const;
+    sf::Vector2u GetSize() const;
+    sf::Color GetColor(uint x, uint y) const;
+    sf::Image ToImage() const;
+
+private:
+    sf::Vector2u m_Size;
+    std::vector<sf::Color> m_Palette;
+    std::vector<uint8_t> m_Indices;
+};
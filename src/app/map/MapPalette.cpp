@@ -0,0 +1,130 @@
+#include "MapPalette.hpp"
+#include "Province.hpp"
+#include "Title.hpp"
+#include "app/mod/Mod.hpp"
+
+// Ids of the provinces without a title at a tier, made from their index
+// so that borders are still drawn between them. Titles ids are lower.
+static constexpr uint32_t UntitledId = 1 << 23;
+
+static uint32_t ToEntry(uint32_t id) {
+    return ProvinceRaster::ToPixel(sf::Color((id >> 16) & 0xFF, (id >> 8) & 0xFF, id & 0xFF, 0xFF));
+}
+
+MapPalette::MapPalette()
+: m_Rows(0) {}
+
+void MapPalette::Load(Mod& mod) {
+    const ProvinceRaster& raster = mod.GetProvinceRaster();
+    m_Rows = std::max(1u, (raster.GetColorsCount() + Width - 1) / Width);
+
+    // The index texture is written once, since the provinces image isn't modified.
+    std::vector<uint32_t> indices(raster.GetColorsCount());
+    for(uint i = 0; i < indices.size(); i++)
+        indices[i] = ProvinceRaster::ToPixel(sf::Color(i & 0xFF, (i >> 8) & 0xFF, 0, 0xFF));
+
+    // Written by bands of rows, to avoid holding a copy of the whole map in RGBA.
+    m_IndicesTexture.create(raster.GetWidth(), raster.GetHeight());
+    uint bandHeight = std::min(raster.GetHeight(), UploadRows);
+    std::vector<sf::Uint8> pixels((std::size_t) raster.GetWidth() * bandHeight * 4);
+
+    for(uint y = 0; y < raster.GetHeight(); y += bandHeight) {
+        uint rowsCount = std::min(bandHeight, raster.GetHeight() - y);
+        raster.Gather(indices, pixels.data(), y, rowsCount);
+        m_IndicesTexture.update(pixels.data(), raster.GetWidth(), rowsCount, 0, y);
+    }
+
+    m_TitlesIds.clear();
+    this->ComputeEntries(mod, m_Colors, m_Titles);
+
+    m_ColorsTexture.create(Width, m_Rows * ModesCount);
+    m_ColorsTexture.update((const sf::Uint8*) m_Colors.data());
+    m_TitlesTexture.create(Width, m_Rows * (uint) TitleType::COUNT);
+    m_TitlesTexture.update((const sf::Uint8*) m_Titles.data());
+}
+
+void MapPalette::Update(Mod& mod) {
+    std::vector<uint32_t> colors;
+    std::vector<uint32_t> titles;
+    this->ComputeEntries(mod, colors, titles);
+
+    UploadChangedRows(m_ColorsTexture, m_Colors, colors);
+    UploadChangedRows(m_TitlesTexture, m_Titles, titles);
+    m_Colors = std::move(colors);
+    m_Titles = std::move(titles);
+}
+
+void MapPalette::Bind(sf::Shader& shader) const {
+    shader.setUniform("provincesTexture", m_IndicesTexture);
+    shader.setUniform("colorsTexture", m_ColorsTexture);
+    shader.setUniform("titlesTexture", m_TitlesTexture);
+    shader.setUniform("textureSize", sf::Vector2f(m_IndicesTexture.getSize()));
+    shader.setUniform("lookupRows", (float) m_Rows);
+}
+
+const sf::Texture& MapPalette::GetIndicesTexture() const {
+    return m_IndicesTexture;
+}
+
+void MapPalette::ComputeEntries(Mod& mod, std::vector<uint32_t>& colors, std::vector<uint32_t>& titles) {
+    const ProvinceRaster& raster = mod.GetProvinceRaster();
+    const std::size_t blockSize = m_Rows * Width;
+    colors.assign(blockSize * ModesCount, 0);
+    titles.assign(blockSize * (uint) TitleType::COUNT, 0);
+
+    for(uint i = 0; i < raster.GetColorsCount(); i++) {
+        uint32_t colorId = raster.GetColorId(i);
+        colors[i] = ProvinceRaster::ToPixel(sf::Color(colorId));
+
+        const auto& province = mod.GetProvinces().find(colorId);
+        Title* title = nullptr;
+        if(province != mod.GetProvinces().end()) {
+            const auto& barony = mod.GetTitles().find(province->second->GetName());
+            if(barony != mod.GetTitles().end())
+                title = barony->second.get();
+        }
+
+        // Same title as Mod::GetProvinceFocusedTitle, found by going up
+        // from the title of the previous tier.
+        for(uint tier = 0; tier < (uint) TitleType::COUNT; tier++) {
+            while(title != nullptr && title->GetLiegeTitle() != nullptr && (uint) title->GetType() < tier && title->GetLiegeTitle()->HasSelectionFocus())
+                title = title->GetLiegeTitle().get();
+
+            std::size_t entry = tier * blockSize + i;
+            if(title == nullptr) {
+                colors[blockSize + entry] = colors[i];
+                titles[entry] = ToEntry(UntitledId + i);
+                continue;
+            }
+
+            sf::Color color = title->GetColor();
+            color.a = 0xFF;
+            colors[blockSize + entry] = ProvinceRaster::ToPixel(color);
+            titles[entry] = ToEntry(this->GetTitleId(title));
+        }
+    }
+}
+
+uint32_t MapPalette::GetTitleId(const Title* title) {
+    const auto& [it, inserted] = m_TitlesIds.try_emplace(title, m_TitlesIds.size() + 1);
+    return it->second;
+}
+
+void MapPalette::UploadChangedRows(sf::Texture& texture, const std::vector<uint32_t>& previous, const std::vector<uint32_t>& entries) {
+    std::size_t rows = entries.size() / Width;
+
+    // Upload each run of consecutive rows which changed as its own
+    // rectangle, since the provinces of a title are spread over the
+    // table and most rows don't change between two updates.
+    for(std::size_t row = 0; row < rows;) {
+        if(std::equal(entries.begin() + row * Width, entries.begin() + (row + 1) * Width, previous.begin() + row * Width)) {
+            row++;
+            continue;
+        }
+
+        std::size_t firstRow = row;
+        while(row < rows && !std::equal(entries.begin() + row * Width, entries.begin() + (row + 1) * Width, previous.begin() + row * Width))
+            row++;
+        texture.update((const sf::Uint8*) (entries.data() + firstRow * Width), Width, row - firstRow, 0, firstRow);
+    }
+}
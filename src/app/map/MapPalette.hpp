@@ -0,0 +1,46 @@
+#pragma once
+
+// Textures used by the provinces shader to draw the provinces and titles
+// map modes from a single texture of the map:
+// - the index of the color of each pixel in the provinces image,
+//   in the red (low byte) and green (high byte) channels.
+// - the color of each index for each map mode.
+// - an id of the title of each index for each title tier, to draw borders.
+// The tables are made of blocks of rows, one per map mode or tier, where
+// each row holds the entries of Width indices. Updates only upload the
+// rows of the entries which changed, so that editing a title is cheap.
+// The index texture itself is never uploaded again after loading.
+class MapPalette {
+public:
+    static constexpr uint Width = 256;
+    // Provinces, then the title tiers.
+    static constexpr uint ModesCount = 1 + (uint) TitleType::COUNT;
+    // Rows of the index texture written at once when loading.
+    static constexpr uint UploadRows = 256;
+
+    MapPalette();
+
+    // Create the textures from the provinces of the mod.
+    void Load(Mod& mod);
+    // Compute the entries again after the provinces or titles changed.
+    void Update(Mod& mod);
+    void Bind(sf::Shader& shader) const;
+
+    const sf::Texture& GetIndicesTexture() const;
+
+private:
+    void ComputeEntries(Mod& mod, std::vector<uint32_t>& colors, std::vector<uint32_t>& titles);
+    uint32_t GetTitleId(const Title* title);
+    static void UploadChangedRows(sf::Texture& texture, const std::vector<uint32_t>& previous, const std::vector<uint32_t>& entries);
+
+private:
+    sf::Texture m_IndicesTexture;
+    sf::Texture m_ColorsTexture;
+    sf::Texture m_TitlesTexture;
+    uint m_Rows;
+
+    // Copies of the entries uploaded to the textures.
+    std::vector<uint32_t> m_Colors;
+    std::vector<uint32_t> m_Titles;
+    std::unordered_map<const Title*, uint32_t> m_TitlesIds;
+};
@@ -69,11 +69,11 @@ TerrainType Province::GetTerrain() const {
     return m_Terrain;
 }
 
-std::string Province::GetCulture() const {
+Symbol Province::GetCulture() const {
     return m_Culture;
 }
 
-std::string Province::GetReligion() const {
+Symbol Province::GetReligion() const {
     return m_Religion;
 }
 
@@ -102,11 +102,11 @@ void Province::SetTerrain(TerrainType terrain) {
     m_Terrain = terrain;
 }
 
-void Province::SetCulture(std::string culture) {
+void Province::SetCulture(Symbol culture) {
     m_Culture = culture;
 }
 
-void Province::SetReligion(std::string religion) {
+void Province::SetReligion(Symbol religion) {
     m_Religion = religion;
 }
 
@@ -122,6 +122,14 @@ SharedPtr<Parser::Node> Province::GetOriginalData() const {
     return m_OriginalData;
 }
 
+uint64_t Province::GetOriginalDataHash() const {
+    return (m_OriginalData == nullptr) ? 0 : m_OriginalData->GetHash();
+}
+
+SharedPtr<Parser::Source> Province::GetOriginalSource() const {
+    return m_OriginalSource;
+}
+
 void Province::SetOriginalFilePath(const std::string& filePath) {
     m_OriginalFilePath = filePath;
 }
@@ -130,6 +138,14 @@ void Province::SetOriginalData(const Parser::Node& data) {
     m_OriginalData = MakeShared<Parser::Node>(data);
 }
 
+void Province::SetOriginalData(Parser::Node&& data) {
+    m_OriginalData = MakeShared<Parser::Node>(std::move(data));
+}
+
+void Province::SetOriginalSource(const SharedPtr<Parser::Source>& source) {
+    m_OriginalSource = source;
+}
+
 sf::Vector2i Province::GetImagePosition() const {
     return m_ImagePosition;
 }
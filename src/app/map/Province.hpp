@@ -48,8 +48,8 @@ public:
     ProvinceFlags GetFlags() const;
     bool HasFlag(ProvinceFlags flag) const;
     TerrainType GetTerrain() const;
-    std::string GetCulture() const;
-    std::string GetReligion() const;
+    Symbol GetCulture() const;
+    Symbol GetReligion() const;
     ProvinceHolding GetHolding() const;
 
     void SetName(std::string name);
@@ -57,14 +57,19 @@ public:
     void SetFlags(ProvinceFlags flags);
     void SetFlag(ProvinceFlags flag, bool enabled);
     void SetTerrain(TerrainType terrain);
-    void SetCulture(std::string culture);
-    void SetReligion(std::string religion);
+    void SetCulture(Symbol culture);
+    void SetReligion(Symbol religion);
     void SetHolding(ProvinceHolding holding);
     
     std::string GetOriginalFilePath() const;
     SharedPtr<Parser::Node> GetOriginalData() const;
+    // Hash of the original data, or 0 without any.
+    uint64_t GetOriginalDataHash() const;
+    SharedPtr<Parser::Source> GetOriginalSource() const;
     void SetOriginalFilePath(const std::string& filePath);
     void SetOriginalData(const Parser::Node& data);
+    void SetOriginalData(Parser::Node&& data);
+    void SetOriginalSource(const SharedPtr<Parser::Source>& source);
     
     sf::Vector2i GetImagePosition() const;
     uint GetImagePixelsCount() const;
@@ -79,12 +84,13 @@ private:
     ProvinceFlags m_Flags;
     TerrainType m_Terrain;
 
-    std::string m_Culture;
-    std::string m_Religion;
+    Symbol m_Culture;
+    Symbol m_Religion;
     ProvinceHolding m_Holding;
 
     std::string m_OriginalFilePath;
     SharedPtr<Parser::Node> m_OriginalData;
+    SharedPtr<Parser::Source> m_OriginalSource;
 
     sf::Vector2i m_ImagePosition;
     uint m_ImagePixelsCount;
@@ -0,0 +1,269 @@
+#include "ProvinceRaster.hpp"
+
+#include <cstring>
+#include <unordered_set>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#endif
+
+// Split the images in bands of rows, more than the threads
+// so that the threads finishing early take the remaining bands.
+static std::size_t GetBandsCount(uint height) {
+    return std::min<std::size_t>(height, Parallel::GetThreadsCount() * 4);
+}
+
+ProvinceRaster::ProvinceRaster()
+: m_Width(0), m_Height(0), m_TransparentPixelsCount(0) {}
+
+void ProvinceRaster::Load(const sf::Image& image) {
+    m_Width = image.getSize().x;
+    m_Height = image.getSize().y;
+    m_Indices.assign((std::size_t) m_Width * m_Height, 0);
+    m_Colors.clear();
+
+    const sf::Uint8* pixels = image.getPixelsPtr();
+    const uint32_t alpha = ToPixel(sf::Color(0, 0, 0, 255));
+    std::size_t bandsCount = GetBandsCount(m_Height);
+    std::size_t bandHeight = (bandsCount == 0) ? 0 : (m_Height + bandsCount - 1) / bandsCount;
+
+    auto readPixel = [&](std::size_t i) {
+        uint32_t pixel;
+        std::memcpy(&pixel, pixels + i * 4, 4);
+        return pixel | alpha;
+    };
+
+    // Collect the colors of each band, then merge them to give
+    // the indices in the order of the colors.
+    std::vector<std::vector<uint32_t>> bandsColors(bandsCount);
+    Parallel::For(bandsCount, [&](std::size_t band) {
+        std::size_t begin = std::min<std::size_t>(band * bandHeight, m_Height) * m_Width;
+        std::size_t end = std::min<std::size_t>((band + 1) * bandHeight, m_Height) * m_Width;
+        std::unordered_set<uint32_t> colors;
+        uint32_t previousPixel = 0;
+
+        for(std::size_t i = begin; i < end; i++) {
+            uint32_t pixel = readPixel(i);
+            if(pixel != previousPixel || i == begin)
+                colors.insert(pixel);
+            previousPixel = pixel;
+        }
+        bandsColors[band].assign(colors.begin(), colors.end());
+    });
+
+    for(const auto& colors : bandsColors)
+        m_Colors.insert(m_Colors.end(), colors.begin(), colors.end());
+    std::sort(m_Colors.begin(), m_Colors.end());
+    m_Colors.erase(std::unique(m_Colors.begin(), m_Colors.end()), m_Colors.end());
+
+    if(m_Colors.size() > std::numeric_limits<uint16_t>::max() + 1)
+        throw std::runtime_error(fmt::format("error: province image has {} colors, more than the {} supported.", m_Colors.size(), std::numeric_limits<uint16_t>::max() + 1));
+
+    std::unordered_map<uint32_t, uint16_t> indices;
+    indices.reserve(m_Colors.size());
+    for(std::size_t i = 0; i < m_Colors.size(); i++)
+        indices[m_Colors[i]] = i;
+
+    // Statistics of the indices found in a band, merged once all the bands are done.
+    struct Accumulator {
+        uint16_t index;
+        uint32_t minX, minY, maxX, maxY;
+        uint64_t sumX = 0, sumY = 0;
+        uint32_t area = 0;
+        uint32_t spansCount = 0;
+    };
+    struct Band {
+        std::vector<Accumulator> accumulators;
+        std::vector<std::pair<uint16_t, Span>> spans;
+        std::size_t transparentPixelsCount = 0;
+        std::size_t firstTransparentPixel = 0;
+    };
+    std::vector<Band> bands(bandsCount);
+
+    // Provinces are made of runs of pixels of the same color, so the index
+    // and the statistics are only searched again when the color changes.
+    Parallel::For(bandsCount, [&](std::size_t bandIndex) {
+        Band& band = bands[bandIndex];
+        std::unordered_map<uint16_t, uint32_t> slots;
+        uint32_t beginY = std::min<std::size_t>(bandIndex * bandHeight, m_Height);
+        uint32_t endY = std::min<std::size_t>((bandIndex + 1) * bandHeight, m_Height);
+
+        for(uint32_t y = beginY; y < endY; y++) {
+            std::size_t row = (std::size_t) y * m_Width;
+
+            for(uint32_t x = 0; x < m_Width;) {
+                uint32_t pixel = readPixel(row + x);
+                uint16_t index = indices.find(pixel)->second;
+                uint32_t length = 0;
+
+                for(; x + length < m_Width && readPixel(row + x + length) == pixel; length++) {
+                    m_Indices[row + x + length] = index;
+                    if(pixels[(row + x + length) * 4 + 3] != 0xFF && band.transparentPixelsCount++ == 0)
+                        band.firstTransparentPixel = row + x + length;
+                }
+
+                const auto& [slot, inserted] = slots.try_emplace(index, band.accumulators.size());
+                if(inserted)
+                    band.accumulators.push_back(Accumulator{index, x, y, x, y});
+
+                Accumulator& accumulator = band.accumulators[slot->second];
+                accumulator.minX = std::min(accumulator.minX, x);
+                accumulator.maxX = std::max(accumulator.maxX, x + length - 1);
+                accumulator.maxY = y;
+                accumulator.sumX += (uint64_t) length * x + (uint64_t) length * (length - 1) / 2;
+                accumulator.sumY += (uint64_t) length * y;
+                accumulator.area += length;
+                accumulator.spansCount++;
+                band.spans.push_back(std::make_pair(index, Span{x, y, length}));
+                x += length;
+            }
+        }
+    });
+
+    // Merge the bands in order, so that the spans stay sorted by row.
+    std::vector<uint64_t> sumsX(m_Colors.size(), 0), sumsY(m_Colors.size(), 0);
+    m_Bounds.assign(m_Colors.size(), sf::IntRect());
+    m_Areas.assign(m_Colors.size(), 0);
+    m_SpansOffsets.assign(m_Colors.size() + 1, 0);
+    m_TransparentPixelsCount = 0;
+    m_FirstTransparentPixel = sf::Vector2i(0, 0);
+
+    for(const Band& band : bands) {
+        for(const Accumulator& accumulator : band.accumulators) {
+            uint16_t index = accumulator.index;
+            sf::IntRect bounds(accumulator.minX, accumulator.minY, accumulator.maxX - accumulator.minX + 1, accumulator.maxY - accumulator.minY + 1);
+
+            if(m_Areas[index] > 0) {
+                int left = std::min(m_Bounds[index].left, bounds.left);
+                int right = std::max(m_Bounds[index].left + m_Bounds[index].width, bounds.left + bounds.width);
+                int bottom = std::max(m_Bounds[index].top + m_Bounds[index].height, bounds.top + bounds.height);
+                bounds = sf::IntRect(left, m_Bounds[index].top, right - left, bottom - m_Bounds[index].top);
+            }
+            m_Bounds[index] = bounds;
+            sumsX[index] += accumulator.sumX;
+            sumsY[index] += accumulator.sumY;
+            m_Areas[index] += accumulator.area;
+            m_SpansOffsets[index + 1] += accumulator.spansCount;
+        }
+
+        if(band.transparentPixelsCount > 0 && m_TransparentPixelsCount == 0)
+            m_FirstTransparentPixel = sf::Vector2i(band.firstTransparentPixel % m_Width, band.firstTransparentPixel / m_Width);
+        m_TransparentPixelsCount += band.transparentPixelsCount;
+    }
+
+    m_Centroids.assign(m_Colors.size(), sf::Vector2f());
+    for(std::size_t i = 0; i < m_Colors.size(); i++) {
+        if(m_Areas[i] > 0)
+            m_Centroids[i] = sf::Vector2f((double) sumsX[i] / m_Areas[i] + 0.5, (double) sumsY[i] / m_Areas[i] + 0.5);
+        m_SpansOffsets[i + 1] += m_SpansOffsets[i];
+    }
+
+    std::vector<uint32_t> cursors(m_SpansOffsets.begin(), m_SpansOffsets.end() - 1);
+    m_Spans.resize(m_SpansOffsets.back());
+    for(const Band& band : bands) {
+        for(const auto& [index, span] : band.spans)
+            m_Spans[cursors[index]++] = span;
+    }
+}
+
+uint ProvinceRaster::GetWidth() const {
+    return m_Width;
+}
+
+uint ProvinceRaster::GetHeight() const {
+    return m_Height;
+}
+
+uint ProvinceRaster::GetColorsCount() const {
+    return m_Colors.size();
+}
+
+const uint16_t* ProvinceRaster::GetIndices() const {
+    return m_Indices.data();
+}
+
+uint16_t ProvinceRaster::GetIndex(uint x, uint y) const {
+    return m_Indices[(std::size_t) y * m_Width + x];
+}
+
+uint32_t ProvinceRaster::GetColorId(uint16_t index) const {
+    sf::Uint8 bytes[4];
+    std::memcpy(bytes, &m_Colors[index], 4);
+    return sf::Color(bytes[0], bytes[1], bytes[2], bytes[3]).toInteger();
+}
+
+bool ProvinceRaster::FindIndex(uint32_t colorId, uint16_t& index) const {
+    uint32_t pixel = ToPixel(sf::Color(colorId));
+    const auto& it = std::lower_bound(m_Colors.begin(), m_Colors.end(), pixel);
+    if(it == m_Colors.end() || *it != pixel)
+        return false;
+    index = it - m_Colors.begin();
+    return true;
+}
+
+std::span<const ProvinceRaster::Span> ProvinceRaster::GetSpans(uint16_t index) const {
+    return std::span<const Span>(m_Spans.data() + m_SpansOffsets[index], m_SpansOffsets[index + 1] - m_SpansOffsets[index]);
+}
+
+sf::IntRect ProvinceRaster::GetBounds(uint16_t index) const {
+    return m_Bounds[index];
+}
+
+sf::Vector2f ProvinceRaster::GetCentroid(uint16_t index) const {
+    return m_Centroids[index];
+}
+
+uint32_t ProvinceRaster::GetArea(uint16_t index) const {
+    return m_Areas[index];
+}
+
+std::size_t ProvinceRaster::GetTransparentPixelsCount() const {
+    return m_TransparentPixelsCount;
+}
+
+sf::Vector2i ProvinceRaster::GetFirstTransparentPixel() const {
+    return m_FirstTransparentPixel;
+}
+
+std::vector<uint32_t> ProvinceRaster::MakeLookupTable() const {
+    return m_Colors;
+}
+
+void ProvinceRaster::Gather(const std::vector<uint32_t>& table, sf::Uint8* pixels) const {
+    this->Gather(table, pixels, 0, m_Height);
+}
+
+void ProvinceRaster::Gather(const std::vector<uint32_t>& table, sf::Uint8* pixels, uint firstRow, uint rowsCount) const {
+    rowsCount = std::min(rowsCount, m_Height - std::min(firstRow, m_Height));
+    std::size_t bandsCount = GetBandsCount(rowsCount);
+    if(bandsCount == 0)
+        return;
+    std::size_t bandHeight = (rowsCount + bandsCount - 1) / bandsCount;
+
+    // Offset the indices so that i is the position of the pixel in the rows.
+    const uint16_t* indices = m_Indices.data() + (std::size_t) firstRow * m_Width;
+
+    Parallel::For(bandsCount, [&](std::size_t band) {
+        std::size_t i = std::min<std::size_t>(band * bandHeight, rowsCount) * m_Width;
+        std::size_t end = std::min<std::size_t>((band + 1) * bandHeight, rowsCount) * m_Width;
+
+        #if defined(__AVX2__)
+        // Widen eight indices to 32 bits and load their colors at once.
+        for(; end - i >= 8; i += 8) {
+            __m256i index8 = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) (indices + i)));
+            __m256i color8 = _mm256_i32gather_epi32((const int*) table.data(), index8, 4);
+            _mm256_storeu_si256((__m256i*) (pixels + i * 4), color8);
+        }
+        #endif
+
+        for(; i < end; i++)
+            std::memcpy(pixels + i * 4, &table[indices[i]], 4);
+    });
+}
+
+uint32_t ProvinceRaster::ToPixel(sf::Color color) {
+    sf::Uint8 bytes[4] = { color.r, color.g, color.b, color.a };
+    uint32_t pixel;
+    std::memcpy(&pixel, bytes, 4);
+    return pixel;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <span>
+
+// Province image decoded into the index of the color of each pixel,
+// so that images of the map modes are made by looking up the color
+// of each index in a table instead of searching each pixel color.
+// Indices are given in the order of the colors, and the colors are
+// opaque (the alpha of the image is ignored).
+// Statistics of the pixels of each index are computed while decoding.
+class ProvinceRaster {
+public:
+    // Run of pixels of the same color on a row.
+    struct Span {
+        uint32_t x;
+        uint32_t y;
+        uint32_t length;
+    };
+
+    ProvinceRaster();
+
+    // Decode the image, which must be loaded again after being modified.
+    void Load(const sf::Image& image);
+
+    uint GetWidth() const;
+    uint GetHeight() const;
+    uint GetColorsCount() const;
+    const uint16_t* GetIndices() const;
+    uint16_t GetIndex(uint x, uint y) const;
+    // Same value as sf::Color::toInteger.
+    uint32_t GetColorId(uint16_t index) const;
+    // Return false if the color isn't in the image.
+    bool FindIndex(uint32_t colorId, uint16_t& index) const;
+
+    // Spans of the index, sorted by row and then by column.
+    std::span<const Span> GetSpans(uint16_t index) const;
+    sf::IntRect GetBounds(uint16_t index) const;
+    sf::Vector2f GetCentroid(uint16_t index) const;
+    uint32_t GetArea(uint16_t index) const;
+
+    // Pixels which aren't opaque, counted in the color they have once opaque.
+    std::size_t GetTransparentPixelsCount() const;
+    sf::Vector2i GetFirstTransparentPixel() const;
+
+    // Table with the color of the image for each index,
+    // to modify before writing an image with Gather.
+    std::vector<uint32_t> MakeLookupTable() const;
+    // Write the color of the table for each pixel into the RGBA pixels,
+    // which must hold GetWidth() * GetHeight() * 4 bytes.
+    void Gather(const std::vector<uint32_t>& table, sf::Uint8* pixels) const;
+    // Same for the rows [firstRow, firstRow + rowsCount), with
+    // pixels holding GetWidth() * rowsCount * 4 bytes.
+    void Gather(const std::vector<uint32_t>& table, sf::Uint8* pixels, uint firstRow, uint rowsCount) const;
+
+    // Value of the color in a table, in the order of the bytes of RGBA pixels.
+    static uint32_t ToPixel(sf::Color color);
+
+private:
+    uint m_Width;
+    uint m_Height;
+    std::vector<uint16_t> m_Indices;
+    // Colors of the indices in the pixels order.
+    std::vector<uint32_t> m_Colors;
+
+    // Spans of index i are in [m_SpansOffsets[i], m_SpansOffsets[i+1]).
+    std::vector<Span> m_Spans;
+    std::vector<uint32_t> m_SpansOffsets;
+    std::vector<sf::IntRect> m_Bounds;
+    std::vector<sf::Vector2f> m_Centroids;
+    std::vector<uint32_t> m_Areas;
+
+    std::size_t m_TransparentPixelsCount;
+    sf::Vector2i m_FirstTransparentPixel;
+};
@@ -68,6 +68,14 @@ SharedPtr<Parser::Node> Title::GetOriginalData() const {
     return m_OriginalData;
 }
 
+uint64_t Title::GetOriginalDataHash() const {
+    return (m_OriginalData == nullptr) ? 0 : m_OriginalData->GetHash();
+}
+
+SharedPtr<Parser::Source> Title::GetOriginalSource() const {
+    return m_OriginalSource;
+}
+
 void Title::SetOriginalFilePath(const std::string& filePath) {
     m_OriginalFilePath = filePath;
 }
@@ -76,6 +84,14 @@ void Title::SetOriginalData(const Parser::Node& data) {
     m_OriginalData = MakeShared<Parser::Node>(data);
 }
 
+void Title::SetOriginalData(Parser::Node&& data) {
+    m_OriginalData = MakeShared<Parser::Node>(std::move(data));
+}
+
+void Title::SetOriginalSource(const SharedPtr<Parser::Source>& source) {
+    m_OriginalSource = source;
+}
+
 bool Title::HasSelectionFocus() const {
     return m_SelectionFocus;
 }
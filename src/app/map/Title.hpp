@@ -27,8 +27,13 @@ public:
     
     std::string GetOriginalFilePath() const;
     SharedPtr<Parser::Node> GetOriginalData() const;
+    // Hash of the original data, or 0 without any.
+    uint64_t GetOriginalDataHash() const;
+    SharedPtr<Parser::Source> GetOriginalSource() const;
     void SetOriginalFilePath(const std::string& filePath);
     void SetOriginalData(const Parser::Node& data);
+    void SetOriginalData(Parser::Node&& data);
+    void SetOriginalSource(const SharedPtr<Parser::Source>& source);
 
     virtual bool HasSelectionFocus() const;
     virtual void SetSelectionFocus(bool focus);
@@ -43,6 +48,7 @@ protected:
 
     std::string m_OriginalFilePath;
     SharedPtr<Parser::Node> m_OriginalData;
+    SharedPtr<Parser::Source> m_OriginalSource;
 
     bool m_SelectionFocus;
 };
@@ -12,13 +12,24 @@ enum class TitleType {
 const std::vector<const char*> TitleTypeLabels = { "Barony", "County", "Duchy", "Kingdom", "Empire" };
 const std::vector<const char*> TitleTypePrefixes = { "b", "c", "d", "k", "e" };
 
-inline TitleType GetTitleTypeByName(const std::string& name) {
+// Return false if the name doesn't start with the prefix of a title type, such as
+// the attributes in title definitions, which are much more common than titles.
+inline bool TryGetTitleTypeByName(std::string_view name, TitleType& type) {
     for(int i = 0; i < (int) TitleType::COUNT; i++) {
-        std::string prefix = std::string(TitleTypePrefixes[i]) + "_";
-        if(name.starts_with(prefix))
-            return (TitleType) i;
+        std::string_view prefix = TitleTypePrefixes[i];
+        if(name.size() > prefix.size() && name.starts_with(prefix) && name[prefix.size()] == '_') {
+            type = (TitleType) i;
+            return true;
+        }
     }
-    throw std::runtime_error("error: invalid title name.");
+    return false;
+}
+
+inline TitleType GetTitleTypeByName(const std::string& name) {
+    TitleType type;
+    if(!TryGetTitleTypeByName(name, type))
+        throw std::runtime_error("error: invalid title name.");
+    return type;
 }
 
 inline std::string GetTitlePrefixByType(TitleType type) {
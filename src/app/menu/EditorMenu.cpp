@@ -50,8 +50,11 @@ SharedPtr<Province> EditorMenu::GetHoveredProvince() {
     SharedPtr<Mod> mod = m_App->GetMod();
     sf::Vector2f mapMousePosition = mousePosition - m_MapSprite.getPosition();
 
-    sf::Color color = mod->GetProvinceImage().getPixel(mapMousePosition.x, mapMousePosition.y);
-    uint32_t colorId = color.toInteger();
+    const ProvinceRaster& raster = mod->GetProvinceRaster();
+    if(mapMousePosition.x >= raster.GetWidth() || mapMousePosition.y >= raster.GetHeight())
+        return nullptr;
+
+    uint32_t colorId = raster.GetColorId(raster.GetIndex(mapMousePosition.x, mapMousePosition.y));
 
     if(mod->GetProvinces().count(colorId) == 0)
         return nullptr;
@@ -119,7 +122,10 @@ void EditorMenu::SwitchMapMode(MapMode mode, bool clearSelection) {
     m_MapMode = mode;
     if(clearSelection)
         m_SelectionHandler.ClearSelection();
-    m_MapSprite.setTexture(m_MapTextures[m_MapMode]);
+    if(m_MapMode == MapMode::PROVINCES || MapModeIsTitle(m_MapMode))
+        m_MapSprite.setTexture(m_MapPalette.GetIndicesTexture());
+    else
+        m_MapSprite.setTexture(m_MapTextures[m_MapMode]);
 }
 
 void EditorMenu::RefreshMapMode(bool clearSelection, bool resetFocus) {
@@ -131,14 +137,12 @@ void EditorMenu::RefreshMapMode(bool clearSelection, bool resetFocus) {
 
 void EditorMenu::UpdateTexture(MapMode mode, bool resetFocus) {
     // Update the pixels of the specified image (from scratch) and then
-    // update the corresponding texture in the shader.
+    // update the corresponding texture in the shader. Provinces and titles
+    // only upload the entries of the palette which changed.
     const SharedPtr<Mod>& mod = m_App->GetMod();
     switch(mode) {
         case MapMode::PROVINCES:
-            // TODO: update pixel colors in mod->m_ProvinceImage
-            m_MapTextures[mode].loadFromImage(mod->GetProvinceImage());
-            Configuration::shaders.Get(Shaders::PROVINCES).setUniform("provincesTexture", m_MapTextures[mode]);
-            Configuration::shaders.Get(Shaders::PROVINCES).setUniform("textureSize", sf::Vector2f(m_MapTextures[mode].getSize()));
+            m_MapPalette.Update(*mod);
             break;
         case MapMode::HEIGHTMAP:
             m_MapTextures[mode].loadFromImage(mod->GetHeightmapImage());
@@ -156,11 +160,6 @@ void EditorMenu::UpdateTexture(MapMode mode, bool resetFocus) {
         case MapMode::KINGDOM:
         case MapMode::EMPIRE: {
             TitleType type = MapModeToTileType(mode);
-            m_MapTextures[mode].loadFromImage(mod->GetTitleImage(type));
-            Configuration::shaders.Get(Shaders::PROVINCES).setUniform(
-                String::ToLowercase(TitleTypeLabels[(int) type]) + "Texture",
-                m_MapTextures[mode]
-            );
 
             // Reset the selection focus for every titles of that tier or below.
             if(resetFocus) {
@@ -168,6 +167,7 @@ void EditorMenu::UpdateTexture(MapMode mode, bool resetFocus) {
                     title->SetSelectionFocus(true);
                 }
             }
+            m_MapPalette.Update(*mod);
             break;
         }
         default:
@@ -178,19 +178,15 @@ void EditorMenu::UpdateTexture(MapMode mode, bool resetFocus) {
 
 void EditorMenu::UpdateTextures() {
     // Update the textures for all map modes. This includes:
-    // - Redraw titles/provinces image pixels (with colors from Province/Title objects).
-    // - Update titles and provinces textures in the shader.
-    std::vector<UniquePtr<sf::Thread>> threads;
-
-    for(MapMode mode = MapMode::PROVINCES; mode < MapMode::COUNT; mode = (MapMode)((int) mode + 1)) {
-        threads.push_back(MakeUnique<sf::Thread>([&, mode](){
-            this->UpdateTexture(mode);
-        }));
-        threads[threads.size()-1]->launch();
-    }
+    // - Redraw heightmap and rivers images pixels.
+    // - Create the palette for provinces and titles (with colors from Province/Title objects)
+    //   and give its textures to the shader.
+    const SharedPtr<Mod>& mod = m_App->GetMod();
+    m_MapTextures[MapMode::HEIGHTMAP].loadFromImage(mod->GetHeightmapImage());
+    m_MapTextures[MapMode::RIVERS].loadFromImage(mod->GetRiversImage());
 
-    for(auto& thread : threads)
-        thread->wait();
+    m_MapPalette.Load(*mod);
+    m_MapPalette.Bind(Configuration::shaders.Get(Shaders::PROVINCES));
 }
 
 void EditorMenu::Update(sf::Time delta) {
@@ -285,7 +281,6 @@ void EditorMenu::Render() {
 
     // Update provinces shader
     sf::Shader& provinceShader = Configuration::shaders.Get(Shaders::PROVINCES);
-    provinceShader.setUniform("texture", sf::Shader::CurrentTexture);
     provinceShader.setUniform("time", m_Clock.getElapsedTime().asSeconds());
     provinceShader.setUniform("mapMode", (int) m_MapMode);
     provinceShader.setUniform("displayBorders", m_DisplayBorders);
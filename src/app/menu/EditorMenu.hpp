@@ -2,6 +2,7 @@
 
 #include "Menu.hpp"
 #include "selection/SelectionHandler.hpp"
+#include "app/map/MapPalette.hpp"
 
 class EditorMenu : public Menu {
 friend SelectionHandler;
@@ -42,6 +43,8 @@ private:
     sf::Clock m_Clock;
 
     std::map<MapMode, sf::Texture> m_MapTextures;
+    // Provinces and titles map modes are drawn from the same textures.
+    MapPalette m_MapPalette;
     sf::Sprite m_MapSprite;
 
     bool m_Dragging;
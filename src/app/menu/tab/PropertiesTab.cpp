@@ -123,10 +123,14 @@ void PropertiesTab::RenderProvinces() {
             }
 
             // PROVINCE: culture (field)
-            ImGui::InputText("culture", &province->m_Culture);
+            std::string culture = province->GetCulture();
+            if(ImGui::InputText("culture", &culture))
+                province->SetCulture(culture);
 
             // PROVINCE: religion (field)
-            ImGui::InputText("religion", &province->m_Religion);
+            std::string religion = province->GetReligion();
+            if(ImGui::InputText("religion", &religion))
+                province->SetReligion(religion);
 
             // PROVINCE: holding type (combobox)
             if (ImGui::BeginCombo("holding", ProvinceHoldingLabels[(int) province->GetHolding()])) {
@@ -266,8 +270,6 @@ void PropertiesTab::RenderTitles() {
                         highTitle->RemoveDejureTitle(dejure);
 
                         // Update the map to remove the dejure title from the title color.
-                        // TODO: it would be better not having to redraw the entire map
-                        // but only the relevant colors.
                         m_Menu->RefreshMapMode();
                     }
                     ImGui::PopID();
@@ -341,27 +343,7 @@ void PropertiesTab::RenderTitles() {
 
                 if(ImGui::Button("Delete", ImVec2(120, 0))) {
                     ImGui::CloseCurrentPopup();
-
-                    // Remove the title from his liege's dejure titles.
-                    if(!title->Is(TitleType::EMPIRE) && title->GetLiegeTitle()) {
-                        const SharedPtr<HighTitle>& liege = title->GetLiegeTitle();
-                        liege->RemoveDejureTitle(title);
-                    }
-
-                    // Remove the title as the liege of all his dejure titles.
-                    if(!title->Is(TitleType::BARONY)) {
-                        const SharedPtr<HighTitle>& highTitle = CastSharedPtr<HighTitle>(title);
-                        for(auto& dejure : highTitle->GetDejureTitles()) {
-                            dejure->SetLiegeTitle(nullptr);
-                        }
-                    }
-
-                    const SharedPtr<Mod>& mod = m_Menu->GetApp()->GetMod();
-                    auto& l = mod->GetTitlesByType()[title->GetType()];
-
-                    mod->GetTitles().erase(title->GetName());
-                    l.erase(std::remove(l.begin(), l.end(), title));
-
+                    m_Menu->GetApp()->GetMod()->DeleteTitle(title);
                     m_Menu->RefreshMapMode(true);
                 }
 
@@ -0,0 +1,263 @@
+#include "Loaders.hpp"
+#include "Mod.hpp"
+#include "app/map/Province.hpp"
+#include "app/map/Title.hpp"
+#include "parser/Diagnostics.hpp"
+
+using Action = Parser::Visitor::Action;
+using Severity = Parser::Diagnostic::Severity;
+
+////////////////////////////////////
+//       TitlesLoader class       //
+////////////////////////////////////
+
+TitlesLoader::TitlesLoader(Mod& mod, const std::string& filePath, const SharedPtr<Parser::Document>& document, bool reload)
+: m_Mod(mod), m_FilePath(filePath), m_Document(document), m_Reload(reload) {}
+
+Action TitlesLoader::OnKey(const Parser::Key& key, Parser::Operator op, std::size_t offset) {
+    TitleType type;
+
+    // Need to check if the key is a title (starts with e_, k_, d_, c_ or b_)
+    // because it could be attributes such as color, capital, can_create...
+    // The blocks of baronies are kept as they are.
+    if((m_Frames.empty() || m_Frames.back().type != TitleType::BARONY) && this->IsTitleKey(key, type)) {
+        // Only the first definition of a title in a same block is used,
+        // as when the whole file is parsed into a node.
+        const auto& siblings = m_Frames.empty() ? m_TitlesNames : m_Frames.back().titlesNames;
+        if(siblings.count(std::get<Symbol>(key)) > 0)
+            return Action::SKIP;
+        return Action::DESCEND;
+    }
+
+    // Attributes at the root of the file are ignored.
+    if(m_Frames.empty())
+        return Action::SKIP;
+
+    // The province is only read for baronies, and the capital for
+    // duchies, kingdoms and empires. Otherwise, they are kept as is.
+    Frame& frame = m_Frames.back();
+    std::size_t field = TitleSchema.IndexOfKey(key);
+
+    if(field == TitleSchema.Size)
+        return Action::MATERIALIZE;
+    if(field == ProvinceField && frame.type != TitleType::BARONY)
+        return Action::MATERIALIZE;
+    if(field == CapitalField && (frame.type == TitleType::BARONY || frame.type == TitleType::COUNTY))
+        return Action::MATERIALIZE;
+
+    // Only the first definition of an attribute is used.
+    if(frame.Has(field))
+        return Action::SKIP;
+    m_Field = field;
+    return Action::DECODE;
+}
+
+void TitlesLoader::OnValue(const Parser::Key& key, Parser::Operator op, Parser::Node& value, Parser::Span span) {
+    // A title defined with a single value instead of a block.
+    if(m_Frames.empty())
+        return;
+    Parser::Impl::AppendEntry(m_Frames.back().data, key, std::move(value), op, m_Document->GetContent(), span.offset);
+}
+
+void TitlesLoader::OnDecode(const Parser::Key& key, Parser::Operator op, Parser::TokenStream& tokens) {
+    Frame& frame = m_Frames.back();
+    std::size_t start = tokens.GetOffset();
+
+    if(TitleSchema.Decode(m_Field, tokens, frame.fields)) {
+        frame.decoded |= 1 << m_Field;
+        frame.spans[m_Field] = Parser::Span{(uint32_t) start, (uint32_t) (tokens.GetEnd() - start)};
+    }
+    else
+        Parser::Diagnostics::Report(tokens.GetContent(), start, Severity::ERROR, fmt::format("invalid {} in title definition: {}", TitleSchema.GetName(m_Field), frame.name));
+}
+
+void TitlesLoader::OnBeginBlock(const Parser::Key& key, Parser::Operator op) {
+    Frame frame;
+    frame.name = std::get<Symbol>(key);
+    this->IsTitleKey(key, frame.type);
+    m_Frames.push_back(std::move(frame));
+}
+
+void TitlesLoader::OnEndBlock(const Parser::Key& key, Parser::Span span) {
+    Frame frame = std::move(m_Frames.back());
+    m_Frames.pop_back();
+    this->AddTitle(frame, span);
+}
+
+bool TitlesLoader::IsTitleKey(const Parser::Key& key, TitleType& type) const {
+    if(!std::holds_alternative<Symbol>(key))
+        return false;
+    return TryGetTitleTypeByName(std::get<Symbol>(key).Str(), type);
+}
+
+SharedPtr<Title> TitlesLoader::CreateTitle(Frame& frame, Parser::Span span) {
+    const Symbol& key = frame.name;
+
+    // Need to use a custom function to create a SharedPtr<Title>
+    // to get the right derived class such as BaronyTitle, CountyTitle...
+    const TitleFields& fields = frame.fields;
+    SharedPtr<Title> title = MakeTitle(frame.type, key, fields.color, fields.landless);
+
+    // The problems are reported at the start of the definition.
+    std::string_view content = m_Document->GetContent();
+    auto report = [&](Severity severity, std::string_view message) {
+        Parser::Diagnostics::Report(content, span.offset, severity, fmt::format("{}: {}", message, key));
+    };
+
+    if(!frame.Has(ColorField))
+        report(Severity::WARNING, "title missing color in definition");
+
+    if(frame.type == TitleType::BARONY) {
+        SharedPtr<BaronyTitle> baronyTitle = CastSharedPtr<BaronyTitle>(title);
+        baronyTitle->SetProvinceId(fields.province);
+
+        if(!frame.Has(ProvinceField))
+            report(Severity::ERROR, "barony title missing province id in definition");
+        if(m_Mod.m_ProvincesByIds.count(baronyTitle->GetProvinceId()) == 0)
+            report(Severity::ERROR, fmt::format("barony title with undefined province id {} in definition", baronyTitle->GetProvinceId()));
+    }
+    else {
+        SharedPtr<HighTitle> highTitle = CastSharedPtr<HighTitle>(title);
+
+        if(fields.landless && !frame.dejureTitles.empty())
+            report(Severity::ERROR, "landless title has dejure vassals in definition");
+        else if(!fields.landless && frame.dejureTitles.empty())
+            report(Severity::ERROR, "title does not have any dejure vassals in definition");
+
+        for(const auto& dejureTitle : frame.dejureTitles)
+            highTitle->AddDejureTitle(dejureTitle);
+
+        if(frame.type != TitleType::COUNTY) {
+            if(frame.Has(CapitalField))
+                m_Mod.m_UnresolvedCapitals.push_back(std::make_pair(highTitle, fields.capital));
+            else
+                report(Severity::ERROR, "title missing county capital in definition");
+        }
+    }
+
+    m_Mod.m_Titles[key] = title;
+    m_Mod.m_TitlesByType[frame.type].push_back(title);
+    return title;
+}
+
+void TitlesLoader::AddTitle(Frame& frame, Parser::Span span) {
+    auto& siblings = m_Frames.empty() ? m_TitlesNames : m_Frames.back().titlesNames;
+    siblings.insert(frame.name);
+
+    SharedPtr<Title> title;
+
+    // Only the source of an existing title is reloaded, and the
+    // entries of the titles which have been deleted are ignored.
+    if(m_Reload) {
+        auto it = m_Mod.m_Titles.find(frame.name);
+        if(it == m_Mod.m_Titles.end())
+            return;
+        title = it->second;
+    }
+    else
+        title = this->CreateTitle(frame, span);
+
+    SharedPtr<Parser::Source> source = MakeShared<Parser::Source>();
+    source->document = m_Document;
+    source->span = span;
+    source->depth = m_Frames.size();
+    source->fields = std::move(frame.spans);
+    source->childrenCount = frame.dejureTitles.size();
+
+    title->SetOriginalFilePath(m_FilePath);
+    title->SetOriginalData(std::move(frame.data));
+    title->SetOriginalSource(source);
+
+    if(m_Frames.empty())
+        m_Titles.push_back(title);
+    else
+        m_Frames.back().dejureTitles.push_back(title);
+}
+
+////////////////////////////////////
+//  ProvincesHistoryLoader class  //
+////////////////////////////////////
+
+ProvincesHistoryLoader::ProvincesHistoryLoader(Mod& mod, const std::string& filePath, const SharedPtr<Parser::Document>& document, bool reload)
+: m_Mod(mod), m_FilePath(filePath), m_Document(document), m_Reload(reload), m_Decoded(0) {}
+
+Action ProvincesHistoryLoader::OnKey(const Parser::Key& key, Parser::Operator op, std::size_t offset) {
+    // Everything inside the block of a province is kept, except
+    // the attributes of the schema which are read separately.
+    if(m_Province != nullptr) {
+        std::size_t field = ProvinceHistorySchema.IndexOfKey(key);
+        if(field == ProvinceHistorySchema.Size)
+            return Action::MATERIALIZE;
+
+        // Only the first definition of an attribute is used.
+        if(m_Decoded & (1 << field))
+            return Action::SKIP;
+        m_Field = field;
+        return Action::DECODE;
+    }
+
+    if(!std::holds_alternative<double>(key))
+        return Action::SKIP;
+
+    int provinceId = std::get<double>(key);
+    if(m_VisitedProvinces.count(provinceId) > 0)
+        return Action::SKIP;
+    m_VisitedProvinces.insert(provinceId);
+
+    if(m_Mod.m_ProvincesByIds.count(provinceId) == 0) {
+        Parser::Diagnostics::Report(m_Document->GetContent(), offset, Severity::ERROR, fmt::format("province history with undefined province id: {}", provinceId));
+        return Action::SKIP;
+    }
+    return Action::DESCEND;
+}
+
+void ProvincesHistoryLoader::OnValue(const Parser::Key& key, Parser::Operator op, Parser::Node& value, Parser::Span span) {
+    // A province defined with a single value instead of a block.
+    if(m_Province == nullptr)
+        return;
+    Parser::Impl::AppendEntry(m_Data, key, std::move(value), op, m_Document->GetContent(), span.offset);
+}
+
+void ProvincesHistoryLoader::OnDecode(const Parser::Key& key, Parser::Operator op, Parser::TokenStream& tokens) {
+    std::size_t start = tokens.GetOffset();
+
+    if(ProvinceHistorySchema.Decode(m_Field, tokens, m_Fields)) {
+        m_Decoded |= 1 << m_Field;
+        m_Spans[m_Field] = Parser::Span{(uint32_t) start, (uint32_t) (tokens.GetEnd() - start)};
+    }
+    else
+        Parser::Diagnostics::Report(tokens.GetContent(), start, Severity::ERROR, fmt::format("invalid {} in province history: {}", ProvinceHistorySchema.GetName(m_Field), m_Province->GetId()));
+}
+
+void ProvincesHistoryLoader::OnBeginBlock(const Parser::Key& key, Parser::Operator op) {
+    m_Province = m_Mod.m_ProvincesByIds[std::get<double>(key)];
+    m_Data = Parser::Node();
+    m_Fields = ProvinceHistoryFields();
+    m_Decoded = 0;
+    m_Spans = std::vector<Parser::Span>(ProvinceHistorySchema.Size);
+}
+
+void ProvincesHistoryLoader::OnEndBlock(const Parser::Key& key, Parser::Span span) {
+    // Those attributes are not kept in the original data to avoid
+    // duplicates when exporting and to reduce memory usage a bit.
+    if(!m_Reload) {
+        if(m_Decoded & (1 << CultureField))
+            m_Province->SetCulture(m_Fields.culture);
+        if(m_Decoded & (1 << ReligionField))
+            m_Province->SetReligion(m_Fields.religion);
+        if(m_Decoded & (1 << HoldingField))
+            m_Province->SetHolding(ProvinceHoldingFromString(m_Fields.holding));
+    }
+
+    SharedPtr<Parser::Source> source = MakeShared<Parser::Source>();
+    source->document = m_Document;
+    source->span = span;
+    source->fields = std::move(m_Spans);
+    source->previous = m_Province->GetOriginalSource();
+
+    m_Province->SetOriginalFilePath(m_FilePath);
+    m_Province->SetOriginalData(std::move(m_Data));
+    m_Province->SetOriginalSource(source);
+    m_Province = nullptr;
+    m_Data = Parser::Node();
+}
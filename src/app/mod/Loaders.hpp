@@ -0,0 +1,121 @@
+#pragma once
+
+#include "parser/Document.hpp"
+#include "parser/Parser.hpp"
+#include "parser/Schema.hpp"
+
+#include <unordered_set>
+
+// Visitors filling the mod from the parser events. Only the attributes
+// kept as original data are materialized as nodes, the others are read
+// as they come and the blocks of the vassal titles are descended into.
+// The spans of the entries and of the decoded attributes are kept along
+// with the document of the file, so that they can be patched in place.
+// Once the files have been written, they are visited again to reload
+// only those sources, and the mod itself is left as it is.
+
+// Attributes of a title decoded with the schema below.
+struct TitleFields {
+    sf::Color color = sf::Color::Black;
+    bool landless = false;
+    int province = 0;
+    Symbol capital;
+};
+
+constexpr Parser::Schema TitleSchema {
+    Parser::Field{"color", &TitleFields::color},
+    Parser::Field{"landless", &TitleFields::landless},
+    Parser::Field{"province", &TitleFields::province},
+    Parser::Field{"capital", &TitleFields::capital},
+};
+
+constexpr std::size_t ColorField = TitleSchema.IndexOf("color");
+constexpr std::size_t LandlessField = TitleSchema.IndexOf("landless");
+constexpr std::size_t ProvinceField = TitleSchema.IndexOf("province");
+constexpr std::size_t CapitalField = TitleSchema.IndexOf("capital");
+
+class TitlesLoader : public Parser::Visitor {
+public:
+    TitlesLoader(Mod& mod, const std::string& filePath, const SharedPtr<Parser::Document>& document, bool reload = false);
+
+    Action OnKey(const Parser::Key& key, Parser::Operator op, std::size_t offset) override;
+    void OnValue(const Parser::Key& key, Parser::Operator op, Parser::Node& value, Parser::Span span) override;
+    void OnBeginBlock(const Parser::Key& key, Parser::Operator op) override;
+    void OnEndBlock(const Parser::Key& key, Parser::Span span) override;
+    void OnDecode(const Parser::Key& key, Parser::Operator op, Parser::TokenStream& tokens) override;
+
+private:
+    // Title whose block is being visited.
+    struct Frame {
+        Symbol name;
+        TitleType type;
+        Parser::Node data;
+        TitleFields fields;
+        // Bit mask of the fields found in the block.
+        uint32_t decoded = 0;
+        std::vector<Parser::Span> spans = std::vector<Parser::Span>(TitleSchema.Size);
+        std::vector<SharedPtr<Title>> dejureTitles;
+        // Names of the titles defined in the block.
+        std::unordered_set<Symbol> titlesNames;
+
+        bool Has(std::size_t field) const { return decoded & (1 << field); }
+    };
+
+    bool IsTitleKey(const Parser::Key& key, TitleType& type) const;
+    SharedPtr<Title> CreateTitle(Frame& frame, Parser::Span span);
+    void AddTitle(Frame& frame, Parser::Span span);
+
+private:
+    Mod& m_Mod;
+    std::string m_FilePath;
+    SharedPtr<Parser::Document> m_Document;
+    bool m_Reload;
+    std::vector<Frame> m_Frames;
+    std::size_t m_Field;
+    // Titles defined at the root of the file.
+    std::vector<SharedPtr<Title>> m_Titles;
+    std::unordered_set<Symbol> m_TitlesNames;
+};
+
+// Attributes of a province history decoded with the schema below.
+struct ProvinceHistoryFields {
+    Symbol culture;
+    Symbol religion;
+    std::string holding;
+};
+
+constexpr Parser::Schema ProvinceHistorySchema {
+    Parser::Field{"culture", &ProvinceHistoryFields::culture},
+    Parser::Field{"religion", &ProvinceHistoryFields::religion},
+    Parser::Field{"holding", &ProvinceHistoryFields::holding},
+};
+
+constexpr std::size_t CultureField = ProvinceHistorySchema.IndexOf("culture");
+constexpr std::size_t ReligionField = ProvinceHistorySchema.IndexOf("religion");
+constexpr std::size_t HoldingField = ProvinceHistorySchema.IndexOf("holding");
+
+class ProvincesHistoryLoader : public Parser::Visitor {
+public:
+    ProvincesHistoryLoader(Mod& mod, const std::string& filePath, const SharedPtr<Parser::Document>& document, bool reload = false);
+
+    Action OnKey(const Parser::Key& key, Parser::Operator op, std::size_t offset) override;
+    void OnValue(const Parser::Key& key, Parser::Operator op, Parser::Node& value, Parser::Span span) override;
+    void OnBeginBlock(const Parser::Key& key, Parser::Operator op) override;
+    void OnEndBlock(const Parser::Key& key, Parser::Span span) override;
+    void OnDecode(const Parser::Key& key, Parser::Operator op, Parser::TokenStream& tokens) override;
+
+private:
+    Mod& m_Mod;
+    std::string m_FilePath;
+    SharedPtr<Parser::Document> m_Document;
+    bool m_Reload;
+    SharedPtr<Province> m_Province;
+    Parser::Node m_Data;
+    ProvinceHistoryFields m_Fields;
+    uint32_t m_Decoded;
+    std::vector<Parser::Span> m_Spans;
+    std::size_t m_Field;
+    // Only the first definition of a province in a file is used,
+    // as when the whole file is parsed into a node.
+    std::set<int> m_VisitedProvinces;
+};
@@ -1,9 +1,14 @@
 #include "Mod.hpp"
+#include "Loaders.hpp"
 #include "app/map/Province.hpp"
 #include "app/map/Title.hpp"
+#include "parser/Cache.hpp"
+#include "parser/Diagnostics.hpp"
 #include "parser/Parser.hpp"
+#include "parser/Writer.hpp"
 
 #include <filesystem>
+#include <numeric>
 #include <fmt/ostream.h>
 
 Mod::Mod(const std::string& dir)
@@ -13,127 +18,38 @@ std::string Mod::GetDir() const {
     return m_Dir;
 }
 
-sf::Image& Mod::GetHeightmapImage() {
-    return m_HeightmapImage;
-}
-
-sf::Image& Mod::GetProvinceImage() {
-    return m_ProvinceImage;
-}
+sf::Image Mod::GetHeightmapImage() {
+    if(m_HeightmapImage.IsEmpty())
+        this->LoadHeightmapImage();
 
-sf::Image& Mod::GetRiversImage() {
-    return m_RiversImage;
+    sf::Image image = m_HeightmapImage.ToImage();
+    if(Configuration::lowMemory)
+        m_HeightmapImage.Clear();
+    return image;
 }
 
-sf::Image Mod::GetTitleImage(TitleType type) {
-    // Used for benchmarking.
-    sf::Clock clock;
-    
-    // Map provinces color to the titles color and then when 
-    // updating the image, swap the color of each pixel.
-    std::unordered_map<sf::Uint32, sf::Uint32> colors;
-
-    for(const auto& [provinceColorId, province] : m_Provinces) {
-
-        if(m_Titles.count(province->GetName()) == 0)
-            continue;
-
-        const SharedPtr<Title>& liege = this->GetProvinceFocusedTitle(province, type);
-        // const SharedPtr<Title>& liege = GetProvinceLiegeTitle(province, type);
-
-        if(liege == nullptr)
-            continue;
-
-        colors[province->GetColor().toInteger()] = liege->GetColor().toInteger();
-    }
-    // fmt::println("mapping colors: {}", String::DurationFormat(clock.restart()));
-    // fmt::println("mapped: {} colors", colors.size());
-
-    uint width = m_ProvinceImage.getSize().x;
-    uint height = m_ProvinceImage.getSize().y;
-    uint pixels = width * height * 4;
-
-    // Use vectors to avoid using SFML getters and setters for pixels.
-    const sf::Uint8* provincesPixels = m_ProvinceImage.getPixelsPtr();
-    std::vector<sf::Uint8> titlesPixels = std::vector<sf::Uint8>();
-    titlesPixels.reserve(width * height * 4);
-    // fmt::println("image=[{}, {}]\tbytes={}", width, height, titlesPixels.capacity());
-    // fmt::println("initializing pixels array: {}", String::DurationFormat(clock.restart()));
-
-    const int threadsCount = 6;
-    std::vector<UniquePtr<sf::Thread>> threads;
-
-    // Split the image vertically between all the threads.
-    const uint threadRange = pixels / threadsCount;
-
-    for(uint i = 0; i < threadsCount; i++) {
-
-        threads.push_back(MakeUnique<sf::Thread>([&, i](){
-            uint startIndex = i * threadRange;
-            uint endIndex = (i == threadsCount-1) ? pixels : (i+1) * threadRange;
-            uint index = startIndex;
-            // // fmt::println("i={}\t[{},{}]", i, startIndex, endIndex);
-
-            sf::Uint32 provinceColor = 0x000000FF;
-            sf::Uint32 previousProvinceColor = 0x00000000;
-
-            // Cast to edit directly the bytes of the color and pixels.
-            // - colorPtr is used to read the color from the provinces map image.
-            // - titlePtr is used to access the color composites (RGBA)
-            //   of the pixels from the array we are painting.
-            // - replacePtr is the liege color to paint on the new texture.
-            char* colorPtr = static_cast<char*>((void*) &provinceColor);
-            char* titlePtr = static_cast<char*>((void*) &titlesPixels[startIndex]);
-            char* replacePtr = NULL;
-            const char alpha = (const char) 0xFF;
-
-            while(index < endIndex) {
-                // Copy the four bytes corresponding to RGBA from the provinces image pixels
-                // to the array for the titles image.
-                // The bytes need to be flipped, otherwise provinceColor would
-                // be ABGR and we couldn't find the associated title color in the map.
-                colorPtr[3] = provincesPixels[index++]; // R
-                colorPtr[2] = provincesPixels[index++]; // G
-                colorPtr[1] = provincesPixels[index++]; // B
-                index++;
-
-                // Search for the corresponding title color in the map only
-                // if it isn't the same color has the previous one.
-                if(previousProvinceColor != provinceColor) {
-                    const auto& it = colors.find(provinceColor);
-                    replacePtr = (it == colors.end()) ? colorPtr : static_cast<char*>((void*) &it->second);
-                }
-                
-                // Replace the bits of the pixel in the titles image
-                // where each byte correspond to a color composite (RGBA).
-                *titlePtr++ = replacePtr[3]; // R
-                *titlePtr++ = replacePtr[2]; // G
-                *titlePtr++ = replacePtr[1]; // B
-                *titlePtr++ = alpha;
-
-                previousProvinceColor = provinceColor;
-            }    
-        
-        }));
-        threads[threads.size()-1]->launch();
-    }
-
-    for(auto& thread : threads)
-        thread->wait();
-    // fmt::println("filling pixels: {}", String::DurationFormat(clock.restart()));
-
-    sf::Image image;
-    image.create(width, height, titlesPixels.data());
-    // texture.update(titlesPixels.data());
-    // fmt::println("initializing image: {}", String::DurationFormat(clock.restart()));
+sf::Image Mod::GetRiversImage() {
+    if(m_RiversImage.IsEmpty())
+        this->LoadRiversImage();
 
+    sf::Image image = m_RiversImage.ToImage();
+    if(Configuration::lowMemory)
+        m_RiversImage.Clear();
     return image;
 }
 
+const ProvinceRaster& Mod::GetProvinceRaster() const {
+    return m_ProvinceRaster;
+}
+
 bool Mod::HasMap() const {
     return std::filesystem::exists(m_Dir + "/map_data/provinces.png");
 }
 
+const Parser::Diagnostics& Mod::GetDiagnostics() const {
+    return m_Diagnostics;
+}
+
 std::map<uint32_t, SharedPtr<Province>>& Mod::GetProvinces() {
     return m_Provinces;
 }
@@ -188,7 +104,7 @@ int Mod::GetMaxProvinceId() const {
     return m_ProvincesByIds.empty() ? -1 : m_ProvincesByIds.rbegin()->first;
 }
 
-std::map<std::string, SharedPtr<Title>>& Mod::GetTitles() {
+std::map<Symbol, SharedPtr<Title>, Symbol::LexicalLess>& Mod::GetTitles() {
     return m_Titles;
 }
 
@@ -196,6 +112,26 @@ std::map<TitleType, std::vector<SharedPtr<Title>>>& Mod::GetTitlesByType() {
     return m_TitlesByType;
 }
 
+void Mod::DeleteTitle(const SharedPtr<Title>& title) {
+    // Remove the title from his liege's dejure titles.
+    if(!title->Is(TitleType::EMPIRE) && title->GetLiegeTitle())
+        title->GetLiegeTitle()->RemoveDejureTitle(title);
+
+    // Remove the title as the liege of all his dejure titles.
+    if(!title->Is(TitleType::BARONY)) {
+        for(auto& dejure : CastSharedPtr<HighTitle>(title)->GetDejureTitles())
+            dejure->SetLiegeTitle(nullptr);
+    }
+
+    if(title->GetOriginalSource() != nullptr)
+        m_DeletedTitles.push_back(title);
+
+    // Erased from m_Titles last since the title may be a reference to its value.
+    auto& titles = m_TitlesByType[title->GetType()];
+    titles.erase(std::remove(titles.begin(), titles.end(), title), titles.end());
+    m_Titles.erase(title->GetName());
+}
+
 void Mod::HarmonizeTitlesColors(const std::vector<SharedPtr<Title>>& titles, sf::Color rgb, float hue, float saturation) {
     // Generate a list of colors with uniformly spaced saturations around
     // the saturation of the original color while picking a random hue.
@@ -230,46 +166,32 @@ void Mod::HarmonizeTitlesColors(const std::vector<SharedPtr<Title>>& titles, sf:
 }
 
 void Mod::GenerateMissingProvinces() {
-    // Loop through the province image and generate provinces for any color
+    // Loop through the colors of the province image, in the order they
+    // appear in the image, and generate provinces for any color
     // that does not already have one.
+    std::vector<uint16_t> indices(m_ProvinceRaster.GetColorsCount());
+    std::iota(indices.begin(), indices.end(), 0);
+    std::sort(indices.begin(), indices.end(), [&](uint16_t a, uint16_t b) {
+        const ProvinceRaster::Span& spanA = m_ProvinceRaster.GetSpans(a).front();
+        const ProvinceRaster::Span& spanB = m_ProvinceRaster.GetSpans(b).front();
+        return std::tie(spanA.y, spanA.x) < std::tie(spanB.y, spanB.x);
+    });
 
     int nextId = 1;
 
-    uint width = m_ProvinceImage.getSize().x;
-    uint height = m_ProvinceImage.getSize().y;
-    uint pixels = width * height * 4;
-    const sf::Uint8* provincesPixels = m_ProvinceImage.getPixelsPtr();
-
-    uint index = 0;
-    sf::Uint32 provinceColor = 0x000000FF;
-    sf::Uint32 previousProvinceColor = 0x00000000;
-
-    // Cast to edit directly the bytes of the color and pixels.
-    // - colorPtr is used to read the color from the provinces map image.
-    char* colorPtr = static_cast<char*>((void*) &provinceColor);
-
-    while(index < pixels) {
-        // Copy the four bytes corresponding to RGB from the provinces image pixels
-        // to the array for the titles image.
-        // The bytes need to be flipped, otherwise provinceColor would
-        // be ABGR and we couldn't find the associated title color in the map.
-        colorPtr[3] = provincesPixels[index++]; // R
-        colorPtr[2] = provincesPixels[index++]; // G
-        colorPtr[1] = provincesPixels[index++]; // B
-        index++;
-        if(previousProvinceColor != provinceColor) {
-            if(m_Provinces.count(provinceColor) == 0) {
-                // Skip ids that are already taken by another province.
-                while(m_ProvincesByIds.count(nextId) != 0)
-                    nextId++;
-
-                SharedPtr<Province> province = MakeShared<Province>(nextId, sf::Color(provinceColor), fmt::format("province_{}", nextId));
-                m_Provinces[province->GetColorId()] = province;
-                m_ProvincesByIds[province->GetId()] = province;
-                nextId++;
-            }
-        }
-        previousProvinceColor = provinceColor;
+    for(uint16_t index : indices) {
+        uint32_t colorId = m_ProvinceRaster.GetColorId(index);
+        if(m_Provinces.count(colorId) != 0)
+            continue;
+
+        // Skip ids that are already taken by another province.
+        while(m_ProvincesByIds.count(nextId) != 0)
+            nextId++;
+
+        SharedPtr<Province> province = MakeShared<Province>(nextId, sf::Color(colorId), fmt::format("province_{}", nextId));
+        m_Provinces[province->GetColorId()] = province;
+        m_ProvincesByIds[province->GetId()] = province;
+        nextId++;
     }
 }
 
@@ -277,16 +199,19 @@ void Mod::Load() {
     if(!this->HasMap())
         return;
 
-    if(!m_HeightmapImage.loadFromFile(m_Dir + "/map_data/heightmap.png")) {
-        ERROR("Failed to load heightmap image at ", m_Dir + "/map_data/heightmap.png");
-    }
-    if(!m_ProvinceImage.loadFromFile(m_Dir + "/map_data/provinces.png")) {
-        FATAL("Failed to load provinces image at ", m_Dir + "/map_data/provinces.png");
-    }
-    if(!m_RiversImage.loadFromFile(m_Dir + "/map_data/rivers.png")) {
-        ERROR("Failed to load rivers image at ", m_Dir + "/map_data/rivers.png");
+    this->LoadHeightmapImage();
+
+    // The provinces image is only kept as the raster.
+    {
+        sf::Image provinceImage;
+        if(!provinceImage.loadFromFile(m_Dir + "/map_data/provinces.png")) {
+            FATAL("Failed to load provinces image at ", m_Dir + "/map_data/provinces.png");
+        }
+        m_ProvinceRaster.Load(provinceImage);
     }
 
+    this->LoadRiversImage();
+
     this->LoadProvincesDefinition();
     this->LoadProvinceImage();
     this->LoadDefaultMapFile();
@@ -294,84 +219,90 @@ void Mod::Load() {
     this->LoadProvincesHistory();
     this->LoadTitles();
     this->LoadTitlesHistory();
+
+    m_Diagnostics.Log();
+}
+
+void Mod::LoadHeightmapImage() {
+    sf::Image image;
+    if(!image.loadFromFile(m_Dir + "/map_data/heightmap.png")) {
+        ERROR("Failed to load heightmap image at ", m_Dir + "/map_data/heightmap.png");
+        return;
+    }
+    if(!m_HeightmapImage.Load(image))
+        WARNING("Heightmap image isn't grayscale, only its red channel is kept: {}", m_Dir + "/map_data/heightmap.png");
+}
+
+void Mod::LoadRiversImage() {
+    sf::Image image;
+    if(!image.loadFromFile(m_Dir + "/map_data/rivers.png")) {
+        ERROR("Failed to load rivers image at ", m_Dir + "/map_data/rivers.png");
+        return;
+    }
+    if(!m_RiversImage.Load(image))
+        WARNING("Rivers image has more than {} colors, the others are replaced: {}", PaletteImage::MaxColors, m_Dir + "/map_data/rivers.png");
 }
 
 void Mod::LoadDefaultMapFile() {
-    Parser::Node result = Parser::Parse(m_Dir + "/map_data/default.map");
+    std::string filePath = m_Dir + "/map_data/default.map";
+    Parser::Node result;
+    {
+        Parser::Diagnostics::Scope scope(&m_Diagnostics, filePath);
+        result = Parser::Parse(filePath);
+    }
 
     // TODO: Coastal provinces??
     
-    const std::vector<double>& lakes = result.Get("lakes", std::vector<double>{});
-    for(double provinceId : lakes) {
+    IntervalList lakes = result.Get("lakes", IntervalList());
+    for(int provinceId : lakes) {
         m_ProvincesByIds[provinceId]->SetFlag(ProvinceFlags::LAKE, true);
     }
     
     // TODO: Islands provinces??
     // TODO: Land provinces??
 
-    const std::vector<double>& seaZones = result.Get("sea_zones", std::vector<double>{});
-    for(double provinceId : seaZones) {
+    IntervalList seaZones = result.Get("sea_zones", IntervalList());
+    for(int provinceId : seaZones) {
         m_ProvincesByIds[provinceId]->SetFlag(ProvinceFlags::SEA, true);
     }
 
-    const std::vector<double>& rivers = result.Get("river_provinces", std::vector<double>{});
-    for(double provinceId : rivers) {
+    IntervalList rivers = result.Get("river_provinces", IntervalList());
+    for(int provinceId : rivers) {
         m_ProvincesByIds[provinceId]->SetFlag(ProvinceFlags::RIVER, true);
     }
     
-    const std::vector<double>& impassableSeas = result.Get("impassable_seas", std::vector<double>{});
-    for(double provinceId : impassableSeas) {
+    IntervalList impassableSeas = result.Get("impassable_seas", IntervalList());
+    for(int provinceId : impassableSeas) {
         m_ProvincesByIds[provinceId]->SetFlag(ProvinceFlags::SEA, true);
         m_ProvincesByIds[provinceId]->SetFlag(ProvinceFlags::IMPASSABLE, true);
     }
     
-    const std::vector<double>& impassableMountains = result.Get("impassable_mountains", std::vector<double>{});
-    for(double provinceId : impassableMountains) {
+    IntervalList impassableMountains = result.Get("impassable_mountains", IntervalList());
+    for(int provinceId : impassableMountains) {
         m_ProvincesByIds[provinceId]->SetFlag(ProvinceFlags::LAND, true);
         m_ProvincesByIds[provinceId]->SetFlag(ProvinceFlags::IMPASSABLE, true);
     }
 }
 
 void Mod::LoadProvinceImage() {
-    const auto& pixels = m_ProvinceImage.getPixelsPtr();
-    std::map<uint32_t, bool> colors;
-
-    uint width = m_ProvinceImage.getSize().x;
-    uint height = m_ProvinceImage.getSize().y;
-    uint totalPixels = width * height * 4;
-    uint32_t previousColor = 0x0;
-
-    for(uint index = 0; index <= totalPixels; index += 4) {
-        uint32_t color = (pixels[index] << 24) + (pixels[index+1] << 16) + (pixels[index+2] << 8) + (pixels[index+3]);
-        
-        uint x = (index / 4) % width;
-        uint y = floor(index / (4*height));
-
-        if((color & 0xFF) != 0xFF) {
-            ERROR("Transparent pixel in province image at coordinates ({},{})", x, y);
-            continue;
-        }
-
-        const auto& province = m_Provinces.find(color);
-        bool hasProvince = (province == m_Provinces.end());
-        bool alreadySeen = (previousColor == color || colors.count(color) > 0);
-
-        previousColor = color;
+    // The pixels of each color are counted when decoding the image in the raster.
+    if(m_ProvinceRaster.GetTransparentPixelsCount() > 0) {
+        sf::Vector2i pixel = m_ProvinceRaster.GetFirstTransparentPixel();
+        ERROR("{} transparent pixels in province image, the first at coordinates ({},{})", m_ProvinceRaster.GetTransparentPixelsCount(), pixel.x, pixel.y);
+    }
 
-        if(!alreadySeen) {
-            colors[color] = true;
-        }
+    for(uint index = 0; index < m_ProvinceRaster.GetColorsCount(); index++) {
+        sf::Color color = sf::Color(m_ProvinceRaster.GetColorId(index));
+        const auto& province = m_Provinces.find(color.toInteger());
 
-        if(!alreadySeen && !hasProvince) {
-            ERROR("Color found in image but missing province from definition.csv: ({},{},{})", pixels[index], pixels[index+1], pixels[index+2]);
+        if(province == m_Provinces.end()) {
+            ERROR("Color found in image but missing province from definition.csv: ({},{},{})", color.r, color.g, color.b);
             continue;
         }
 
-        if(hasProvince) {
-            if(!alreadySeen)
-                province->second->SetImagePosition(sf::Vector2i(x, y));
-            province->second->IncrementImagePixelsCount();
-        }
+        const ProvinceRaster::Span& span = m_ProvinceRaster.GetSpans(index).front();
+        province->second->SetImagePosition(sf::Vector2i(span.x, span.y));
+        province->second->SetImagePixelsCount(m_ProvinceRaster.GetArea(index));
     }
 }
 
@@ -413,7 +344,12 @@ void Mod::LoadProvincesDefinition() {
 }
 
 void Mod::LoadProvincesTerrain() {
-    Parser::Node result = Parser::Parse(m_Dir + "/common/province_terrain/00_province_terrain.txt");
+    std::string filePath = m_Dir + "/common/province_terrain/00_province_terrain.txt";
+    Parser::Node result;
+    {
+        Parser::Diagnostics::Scope scope(&m_Diagnostics, filePath);
+        result = Parser::Parse(filePath);
+    }
 
     m_DefaultLandTerrain = TerrainTypefromString(result.Get("default_land", std::string("plains")));
     m_DefaultSeaTerrain = TerrainTypefromString(result.Get("default_sea", std::string("sea")));
@@ -459,33 +395,32 @@ void Mod::LoadProvincesTerrain() {
 }
 
 void Mod::LoadProvincesHistory() {
-    std::set<std::string> filesPath = File::ListFiles(m_Dir + "/history/provinces/");
+    this->VisitProvincesHistory(m_Diagnostics, false);
+}
 
-    for(const auto& filePath : filesPath) {
-        Parser::Node data = Parser::Parse(filePath);
-        
-        for(auto& [key, pair] : data.GetEntries()) {
-            if(!std::holds_alternative<double>(key))
-                continue;
-            auto& [op, value] = pair;
-            int provinceId = std::get<double>(key);
-
-            if(value.ContainsKey("culture"))
-                m_ProvincesByIds[provinceId]->SetCulture(value.Get("culture"));
-            if(value.ContainsKey("religion"))
-                m_ProvincesByIds[provinceId]->SetReligion(value.Get("religion"));
-            if(value.ContainsKey("holding"))
-                m_ProvincesByIds[provinceId]->SetHolding(ProvinceHoldingFromString(value.Get("holding")));
-
-            // Remove those attributes to avoid duplicates when exporting
-            // and to reduce memory usage a bit.
-            value.Remove("culture");
-            value.Remove("religion");
-            value.Remove("holding");
-
-            m_ProvincesByIds[provinceId]->SetOriginalFilePath(filePath);
-            m_ProvincesByIds[provinceId]->SetOriginalData(value);
-        }
+void Mod::VisitProvincesHistory(Parser::Diagnostics& diagnostics, bool reload) {
+    std::set<std::string> filesPathSet = File::ListFiles(m_Dir + "/history/provinces/");
+    std::vector<std::string> filesPath(filesPathSet.begin(), filesPathSet.end());
+
+    // Lex all the files at once, but visit them in the sorted
+    // order so that later files still override the previous ones.
+    std::vector<UniquePtr<File::MappedFile>> files(filesPath.size());
+    std::vector<UniquePtr<Parser::TokenStream>> filesTokens(filesPath.size());
+    Parser::Cache cache(m_Dir);
+    Parallel::For(filesPath.size(), [&](std::size_t i) {
+        Parser::Diagnostics::Scope scope(&diagnostics, filesPath[i]);
+        files[i] = MakeUnique<File::MappedFile>(filesPath[i]);
+        filesTokens[i] = cache.GetTokens(filesPath[i], files[i]->GetContent());
+    });
+
+    for(std::size_t i = 0; i < filesPath.size(); i++) {
+        // The content is kept to patch the file when exporting.
+        SharedPtr<Parser::Document> document = MakeShared<Parser::Document>(filesPath[i], std::string(files[i]->GetContent()));
+        ProvincesHistoryLoader loader(*this, filesPath[i], document, reload);
+        Parser::Diagnostics::Scope scope(&diagnostics, filesPath[i]);
+        Parser::Visit(*filesTokens[i], loader);
+        filesTokens[i] = nullptr;
+        files[i] = nullptr;
     }
 }
 
@@ -494,107 +429,57 @@ void Mod::LoadTitlesHistory() {
 }
 
 void Mod::LoadTitles() {
-    std::set<std::string> filesPath = File::ListFiles(m_Dir + "/common/landed_titles/");
-
     for(int i = 0; i < (int) TitleType::COUNT; i++)
         m_TitlesByType[(TitleType) i] = std::vector<SharedPtr<Title>>();
 
-    for(const auto& filePath : filesPath) {
-        // fmt::println("loading titles from {}", filePath);
-        Parser::Node data = Parser::Parse(filePath);
-        std::vector<SharedPtr<Title>> titles = ParseTitles(filePath, data);
-    }
+    std::size_t filesCount = this->VisitTitles(m_Diagnostics, false);
+    this->ResolveTitlesCapitals();
 
-    INFO("loaded {} titles from {} files", m_Titles.size(), filesPath.size());
+    INFO("loaded {} titles from {} files", m_Titles.size(), filesCount);
     
     for(int i = 0; i < (int) TitleType::COUNT; i++)
         INFO("loaded {} {} titles", m_TitlesByType[(TitleType) i].size(), TitleTypeLabels[i]);
 }
 
-std::vector<SharedPtr<Title>> Mod::ParseTitles(const std::string& filePath, Parser::Node& data) {
-    std::vector<SharedPtr<Title>> titles;
+std::size_t Mod::VisitTitles(Parser::Diagnostics& diagnostics, bool reload) {
+    std::set<std::string> filesPath = File::ListFiles(m_Dir + "/common/landed_titles/");
+    std::vector<std::string> sortedFilesPath(filesPath.begin(), filesPath.end());
+    std::vector<UniquePtr<File::MappedFile>> files(sortedFilesPath.size());
+    std::vector<UniquePtr<Parser::TokenStream>> filesTokens(sortedFilesPath.size());
+    Parser::Cache cache(m_Dir);
+
+    Parallel::For(sortedFilesPath.size(), [&](std::size_t i) {
+        Parser::Diagnostics::Scope scope(&diagnostics, sortedFilesPath[i]);
+        files[i] = MakeUnique<File::MappedFile>(sortedFilesPath[i]);
+        filesTokens[i] = cache.GetTokens(sortedFilesPath[i], files[i]->GetContent());
+    });
+
+    // The titles are created in the sorted order of the files, and
+    // the references to other titles are resolved afterwards.
+    for(std::size_t i = 0; i < sortedFilesPath.size(); i++) {
+        SharedPtr<Parser::Document> document = MakeShared<Parser::Document>(sortedFilesPath[i], std::string(files[i]->GetContent()));
+        TitlesLoader loader(*this, sortedFilesPath[i], document, reload);
+        Parser::Diagnostics::Scope scope(&diagnostics, sortedFilesPath[i]);
+        Parser::Visit(*filesTokens[i], loader);
+        filesTokens[i] = nullptr;
+        files[i] = nullptr;
+    }
+    return filesPath.size();
+}
 
-    for(auto& [k, pair] : data.GetEntries()) {
-        if(!std::holds_alternative<std::string>(k))
+void Mod::ResolveTitlesCapitals() {
+    for(const auto& [title, capitalName] : m_UnresolvedCapitals) {
+        auto it = m_Titles.find(capitalName);
+        if(it == m_Titles.end() || !IsInstance<CountyTitle>(it->second)) {
+            // Reported at the capital in the file of the definition.
+            SharedPtr<Parser::Source> source = title->GetOriginalSource();
+            Parser::Diagnostics::Scope scope(&m_Diagnostics, source->document->GetFilePath());
+            Parser::Diagnostics::Report(source->document->GetContent(), source->fields[CapitalField].offset, Parser::Diagnostic::Severity::ERROR, fmt::format("title capital is not a defined county in definition: {}, {}", title->GetName(), capitalName));
             continue;
-        std::string key = std::get<std::string>(k);
-        auto& [op, value] = pair;
-
-        // Need to check if the key is a title (starts with e_, k_, d_, c_ or b_)
-        // because it could be attributes such as color, capital, can_create...
-
-        try {
-            // This function throws an exception if key does not
-            // correspond to a title type.
-            TitleType type = GetTitleTypeByName(key);
-
-            sf::Color color = value.Get("color", sf::Color::Black);
-            bool landless = value.Get("landless", false);
-
-            // Need to use a custom function to create a SharedPtr<Title>
-            // to get the right derived class such as BaronyTitle, CountyTitle...
-            SharedPtr<Title> title = MakeTitle(type, key, color, landless);
-
-            if(!value.ContainsKey("color"))
-                WARNING("Title missing color in definition: {}", key);
-
-            if(type == TitleType::BARONY) {
-                SharedPtr<BaronyTitle> baronyTitle = CastSharedPtr<BaronyTitle>(title);
-                baronyTitle->SetProvinceId(value.Get("province", 0));
-                
-                if(!value.ContainsKey("province"))
-                    ERROR("Barony title missing province id in definition: {}", key);
-                if(m_ProvincesByIds.count(baronyTitle->GetProvinceId()) == 0)
-                    ERROR("Barony title with undefined province id in definition: {},{}", key, baronyTitle->GetProvinceId());
-
-                value.Remove("province");
-            }
-            else {
-                SharedPtr<HighTitle> highTitle = CastSharedPtr<HighTitle>(title);
-                std::vector<SharedPtr<Title>> dejureTitles = ParseTitles(filePath, value);
-
-                if(landless && !dejureTitles.empty())
-                    ERROR("Landless title has dejure vassals in definition: {}", key);
-                else if(!landless && dejureTitles.empty())
-                    ERROR("Title does not have any dejure vassals in definition: {}", key);
-
-                for(const auto& dejureTitle : dejureTitles) {
-                    highTitle->AddDejureTitle(dejureTitle);
-
-                    // Remove that title from the node tree to keep only
-                    // the title own attributes for its original data.
-                    value.Remove(dejureTitle->GetName());
-                }
-
-                if(type != TitleType::COUNTY) {
-                    if(value.ContainsKey("capital")) {
-                        std::string capitalName = value.Get("capital");
-                        if(m_Titles.count(capitalName) > 0 && IsInstance<CountyTitle>(m_Titles[capitalName])) {
-                            highTitle->SetCapitalTitle(CastSharedPtr<CountyTitle>(m_Titles[capitalName]));
-                        }
-                        value.Remove("capital");
-                    }
-                    else {
-                        ERROR("Title missing county capital in definition: {}", key);
-                    }
-                }
-            }
-
-            value.Remove("color");
-            value.Remove("landless");
-            title->SetOriginalFilePath(filePath);
-            title->SetOriginalData(value);
-
-            m_Titles[key] = title;
-            m_TitlesByType[type].push_back(title);
-            titles.push_back(title);
-        }
-        catch(const std::runtime_error& e) {
-            // fmt::println("error: {}", e.what());
         }
+        title->SetCapitalTitle(CastSharedPtr<CountyTitle>(it->second));
     }
-
-    return titles;
+    m_UnresolvedCapitals.clear();
 }
 
 void Mod::Export() {
@@ -611,36 +496,45 @@ void Mod::ExportDefaultMapFile() {
     // such as: sea_zones, impassable_seas, lakes, impassable_mountains, river_provinces
     Parser::Node data = Parser::Parse(m_Dir + "/map_data/default.map");
 
-    data.Put("sea_zones", Parser::Node(std::vector<double>()));
-    data.Put("impassable_seas", Parser::Node(std::vector<double>()));
-    data.Put("lakes", Parser::Node(std::vector<double>()));
-    data.Put("impassable_mountains", Parser::Node(std::vector<double>()));
-    data.Put("river_provinces", Parser::Node(std::vector<double>()));
-
-    // TODO: improve function to use range instead of giant list of ids.
+    // The provinces are sorted by id, so they only extend
+    // the last range of the lists or start a new one.
+    IntervalList seaZones, impassableSeas, lakes, impassableMountains, rivers;
 
     for(const auto& [id, province] : m_ProvincesByIds) {
         if(province->HasFlag(ProvinceFlags::SEA)) {
-            data.Get("sea_zones").Push((double) id);
+            seaZones.Add(id);
             if(province->HasFlag(ProvinceFlags::IMPASSABLE))
-                data.Get("impassable_seas").Push((double) id);
+                impassableSeas.Add(id);
         }
         else if(province->HasFlag(ProvinceFlags::IMPASSABLE)) {
-                data.Get("impassable_mountains").Push((double) id);
+                impassableMountains.Add(id);
         }
 
         if(province->HasFlag(ProvinceFlags::LAKE))
-            data.Get("lakes").Push((double) id);
+            lakes.Add(id);
             
         if(province->HasFlag(ProvinceFlags::RIVER))
-            data.Get("river_provinces").Push((double) id);
+            rivers.Add(id);
     }
 
+    // Empty lists are not written at all.
+    auto putList = [&](const std::string& key, const IntervalList& list) {
+        if(list.Empty())
+            data.Remove(key);
+        else
+            data.Put(key, list);
+    };
+    putList("sea_zones", seaZones);
+    putList("impassable_seas", impassableSeas);
+    putList("lakes", lakes);
+    putList("impassable_mountains", impassableMountains);
+    putList("river_provinces", rivers);
+
     // TODO: add error log if file can't be opened.
 
     std::ofstream file(m_Dir + "/map_data/default.map", std::ios::out);
-    fmt::println(file, "{}", data);
-    file.close();
+    Parser::Writer writer(file);
+    writer.Write(data);
 }
 
 void Mod::ExportProvincesDefinition() {
@@ -700,22 +594,107 @@ void Mod::ExportProvincesTerrain() {
     file.close();
 }
 
-void Mod::ExportProvincesHistory() {
-    // Provinces history are written in a file named after the kingdom tier title
-    // such as: history/provinces/00_k_dorne_prov.txt
+// Decode the original value of a field of an entry, or of the previous
+// entries of the same object, or return the default value if it wasn't
+// in any of them or is invalid.
+template <typename T>
+static T DecodeOriginal(const Parser::Source& source, std::size_t field, T defaultValue) {
+    if(source.fields[field].Empty())
+        return (source.previous == nullptr) ? defaultValue : DecodeOriginal(*source.previous, field, defaultValue);
+    Parser::TokenStream tokens(source.document->GetText(source.fields[field]));
+    T value = defaultValue;
+    if(!Parser::Impl::Decode(tokens, value))
+        return defaultValue;
+    return value;
+}
 
-    // TODO: it may be a better approach to loop through
-    // the list of kingdoms and write their dejure provinces
-    // instead of looping the provinces and having the file/kingdom
-    // in disorder.
+// Check if the vassals of the title are still those nested in its original entry.
+static bool HasOriginalVassals(const SharedPtr<Title>& title) {
+    const Parser::Source& source = *title->GetOriginalSource();
+    if(title->Is(TitleType::BARONY))
+        return true;
+
+    const auto& dejureTitles = CastSharedPtr<HighTitle>(title)->GetDejureTitles();
+    if(dejureTitles.size() != source.childrenCount)
+        return false;
+
+    uint32_t offset = source.span.offset;
+    for(const auto& dejureTitle : dejureTitles) {
+        SharedPtr<Parser::Source> vassalSource = dejureTitle->GetOriginalSource();
+        if(vassalSource == nullptr || vassalSource->document != source.document || vassalSource->depth != source.depth + 1)
+            return false;
+        if(vassalSource->span.offset <= offset || vassalSource->span.End() > source.span.End())
+            return false;
+        offset = vassalSource->span.offset;
+    }
+    return true;
+}
+
+// Write the entries at the end of the original document of
+// the file if there is one, or in a new file otherwise.
+static void WriteEntries(const std::string& filePath, std::string_view entries, std::map<std::string, SharedPtr<Parser::Document>>& documents, std::map<std::string, std::vector<Parser::Patch>>& patches) {
+    auto it = documents.find(filePath);
+
+    // A file without any entry loaded from it, such as one with only
+    // comments, is read as a document to keep its content.
+    if(it == documents.end() && std::filesystem::exists(filePath)) {
+        File::MappedFile file(filePath);
+        it = documents.emplace(filePath, MakeShared<Parser::Document>(filePath, std::string(file.GetContent()))).first;
+    }
+
+    if(it == documents.end()) {
+        std::ofstream file(filePath, std::ios::out | std::ios::binary);
+        file.write(entries.data(), entries.size());
+        return;
+    }
+
+    std::string_view content = it->second->GetContent();
+    std::string text = (content.empty() || content.ends_with('\n')) ? "" : "\n";
+    text += entries;
+    patches[filePath].push_back(Parser::Patch{Parser::Span{(uint32_t) content.size(), 0}, text});
+}
+
+// Write back the documents which have been patched, the others are left untouched.
+static void WriteDocuments(const std::map<std::string, SharedPtr<Parser::Document>>& documents, std::map<std::string, std::vector<Parser::Patch>>& patches) {
+    for(const auto& [filePath, document] : documents) {
+        auto it = patches.find(filePath);
+        if(it == patches.end() || it->second.empty())
+            continue;
+        std::ofstream file(filePath, std::ios::out | std::ios::binary);
+        document->Write(file, std::move(it->second));
+    }
+}
+
+void Mod::ExportProvincesHistory() {
+    // The provinces loaded from a history file are patched in place, so that only
+    // the values which changed are written again. The other provinces are written
+    // in a file named after the kingdom tier title such as:
+    // history/provinces/00_k_dorne_prov.txt
 
     std::string dir = m_Dir + "/history/provinces";
-    std::filesystem::remove_all(dir);
     std::filesystem::create_directories(dir);
 
-    std::map<std::string, std::ofstream> files;
+    std::map<std::string, SharedPtr<Parser::Document>> documents;
+    std::map<std::string, std::vector<Parser::Patch>> patches;
+    std::map<std::string, std::vector<SharedPtr<Province>>> provincesByFile;
 
     for(const auto& [id, province] : m_ProvincesByIds) {
+        SharedPtr<Parser::Source> source = province->GetOriginalSource();
+        if(source != nullptr) {
+            for(const Parser::Source* entry = source.get(); entry != nullptr; entry = entry->previous.get())
+                documents[entry->document->GetFilePath()] = entry->document;
+
+            // Only the history of land provinces is kept, so every entry of
+            // the others is removed, including those of the files loaded before.
+            if(province->HasFlag(ProvinceFlags::LAND)) {
+                this->PatchProvinceHistory(province, patches);
+                continue;
+            }
+            for(const Parser::Source* entry = source.get(); entry != nullptr; entry = entry->previous.get())
+                patches[entry->document->GetFilePath()].push_back(Parser::Patch{entry->span, ""});
+            continue;
+        }
+
         if(!province->HasFlag(ProvinceFlags::LAND))
             continue;
         SharedPtr<Title> kingdomTitle = this->GetProvinceLiegeTitle(province, TitleType::KINGDOM);
@@ -723,54 +702,180 @@ void Mod::ExportProvincesHistory() {
             ERROR("Province cannot be saved because missing dejure kingdom tier liege: {}", id);
             continue;
         }
-        if(files.count(kingdomTitle->GetName()) == 0) {
-            std::string filePath = fmt::format("{}/00_{}_prov.txt", dir, kingdomTitle->GetName());
-            files[kingdomTitle->GetName()] = std::ofstream(filePath, std::ios::out);
+        std::string filePath = fmt::format("{}/00_{}_prov.txt", dir, kingdomTitle->GetName());
+        provincesByFile[filePath].push_back(province);
+    }
+
+    for(const auto& [filePath, provinces] : provincesByFile) {
+        Parser::Writer writer;
+        for(const auto& province : provinces) {
+            writer.WriteComment(province->GetName());
+            writer.WriteEntry((double) province->GetId(), Parser::Operator::EQUAL, this->ExportProvinceHistory(province));
         }
-        std::ofstream& file = files[kingdomTitle->GetName()];
+        WriteEntries(filePath, writer.GetContent(), documents, patches);
+    }
 
-        Parser::Node data = *province->GetOriginalData();
-        if(!province->GetCulture().empty()) data.Put("culture", province->GetCulture());
-        if(!province->GetReligion().empty()) data.Put("religion", province->GetReligion());
-        data.Put("holding", ProvinceHoldingLabels[(int) province->GetHolding()]);
-        data.SetDepth(1);
+    WriteDocuments(documents, patches);
 
-        fmt::println(file, "# {}", province->GetName());
-        fmt::println(file, "{} = {}", province->GetId(), data);
-    }
+    // The sources refer to the content of the files before they were written,
+    // so they are reloaded for the next export. The problems of the files have
+    // already been reported when loading them.
+    for(const auto& [id, province] : m_ProvincesByIds)
+        province->SetOriginalSource(nullptr);
+    Parser::Diagnostics diagnostics;
+    this->VisitProvincesHistory(diagnostics, true);
+}
+
+Parser::Node Mod::ExportProvinceHistory(const SharedPtr<Province>& province) {
+    Parser::Node data = (province->GetOriginalData() == nullptr) ? Parser::Node() : *province->GetOriginalData();
+    if(!province->GetCulture().Empty()) data.Put("culture", province->GetCulture());
+    else data.Remove("culture");
+    if(!province->GetReligion().Empty()) data.Put("religion", province->GetReligion());
+    else data.Remove("religion");
+    data.Put("holding", ProvinceHoldingLabels[(int) province->GetHolding()]);
+    return data;
+}
+
+void Mod::PatchProvinceHistory(const SharedPtr<Province>& province, std::map<std::string, std::vector<Parser::Patch>>& patches) {
+    const Parser::Source& source = *province->GetOriginalSource();
+    std::vector<Parser::Patch>& filePatches = patches[source.document->GetFilePath()];
+
+    // A value which has been cleared is removed from every entry
+    // of the province, otherwise that of a previous one is used.
+    auto removeField = [&](std::size_t field) {
+        for(const Parser::Source* entry = &source; entry != nullptr; entry = entry->previous.get()) {
+            if(!entry->fields[field].Empty())
+                patches[entry->document->GetFilePath()].push_back(entry->RemoveField(field));
+        }
+    };
 
-    for(auto& [key, file] : files)
-        file.close();
+    Symbol culture = DecodeOriginal(source, CultureField, Symbol());
+    if(province->GetCulture().Empty() && !culture.Empty())
+        removeField(CultureField);
+    else if(province->GetCulture() != culture)
+        filePatches.push_back(source.PatchField(CultureField, "culture", province->GetCulture().Str()));
+
+    Symbol religion = DecodeOriginal(source, ReligionField, Symbol());
+    if(province->GetReligion().Empty() && !religion.Empty())
+        removeField(ReligionField);
+    else if(province->GetReligion() != religion)
+        filePatches.push_back(source.PatchField(ReligionField, "religion", province->GetReligion().Str()));
+
+    ProvinceHolding holding = ProvinceHoldingFromString(DecodeOriginal(source, HoldingField, std::string()));
+    if(province->GetHolding() != holding)
+        filePatches.push_back(source.PatchField(HoldingField, "holding", ProvinceHoldingLabels[(int) province->GetHolding()]));
 }
 
 void Mod::ExportTitles() {
+    // The titles at the root of their original file are patched in place, and
+    // only the entries of titles whose vassals changed are written again.
     std::string dir = m_Dir + "/common/landed_titles";
     std::filesystem::create_directories(dir);
 
-    std::map<std::string, std::ofstream> files;
+    std::map<std::string, SharedPtr<Parser::Document>> documents;
+    std::map<std::string, std::vector<Parser::Patch>> patches;
+    std::map<std::string, std::vector<SharedPtr<Title>>> titlesByFile;
+
+    // The entries of deleted titles at the root of their file are removed. Those
+    // nested in another entry are removed when their liege is written again,
+    // and their vassals, which are now without liege, are written at the end.
+    for(const auto& title : m_DeletedTitles) {
+        SharedPtr<Parser::Source> source = title->GetOriginalSource();
+        documents[title->GetOriginalFilePath()] = source->document;
+        if(source->depth == 0)
+            patches[title->GetOriginalFilePath()].push_back(Parser::Patch{source->span, ""});
+    }
 
     for(const auto& [name, title] : m_Titles) {
-        if(title->GetLiegeTitle() != nullptr)
+        SharedPtr<Parser::Source> source = title->GetOriginalSource();
+        if(source != nullptr)
+            documents[title->GetOriginalFilePath()] = source->document;
+        bool isRoot = (source != nullptr && source->depth == 0);
+
+        if(title->GetLiegeTitle() != nullptr) {
+            // The title has been moved inside the entry of its liege.
+            if(isRoot)
+                patches[title->GetOriginalFilePath()].push_back(Parser::Patch{source->span, ""});
             continue;
+        }
+
+        if(isRoot) {
+            this->PatchTitle(title, patches[title->GetOriginalFilePath()]);
+            continue;
+        }
         std::string filePath = title->GetOriginalFilePath();
         if(filePath.empty())
             filePath = dir + "/01_landed_titles.txt";
-        if(files.count(filePath) == 0)
-            files[filePath] = std::ofstream(filePath, std::ios::out);
-        std::ofstream& file = files[filePath];
-        Parser::Node data = this->ExportTitle(title, 1);
-        fmt::println(file, "{} = {}", title->GetName(), data);
+        titlesByFile[filePath].push_back(title);
+    }
+
+    for(const auto& [filePath, titles] : titlesByFile) {
+        Parser::Writer writer;
+        for(const auto& title : titles)
+            writer.WriteEntry(title->GetName(), Parser::Operator::EQUAL, this->ExportTitle(title));
+        WriteEntries(filePath, writer.GetContent(), documents, patches);
     }
 
-    for(auto& [key, file] : files)
-        file.close();
+    WriteDocuments(documents, patches);
+
+    // Same as for the provinces history, and the entries
+    // of the deleted titles aren't in the files anymore.
+    m_DeletedTitles.clear();
+    for(const auto& [name, title] : m_Titles)
+        title->SetOriginalSource(nullptr);
+    Parser::Diagnostics diagnostics;
+    this->VisitTitles(diagnostics, true);
+}
+
+void Mod::PatchTitle(const SharedPtr<Title>& title, std::vector<Parser::Patch>& patches) {
+    const Parser::Source& source = *title->GetOriginalSource();
+
+    // The whole entry is written again if vassals have been added,
+    // removed or moved. The indentation before the key is kept.
+    if(!HasOriginalVassals(title)) {
+        Parser::Writer writer;
+        writer.WriteEntry(title->GetName(), Parser::Operator::EQUAL, this->ExportTitle(title), source.depth);
+        patches.push_back(Parser::Patch{source.span, std::string(writer.GetContent().substr(source.depth))});
+        return;
+    }
+
+    sf::Color color = DecodeOriginal(source, ColorField, sf::Color::Black);
+    if(title->GetColor() != color)
+        patches.push_back(source.PatchField(ColorField, "color", fmt::format("{}", Parser::Node(title->GetColor()))));
+
+    bool landless = DecodeOriginal(source, LandlessField, false);
+    if(title->IsLandless() != landless)
+        patches.push_back(source.PatchField(LandlessField, "landless", title->IsLandless() ? "yes" : "no"));
+
+    if(title->Is(TitleType::BARONY)) {
+        SharedPtr<BaronyTitle> baronyTitle = CastSharedPtr<BaronyTitle>(title);
+        int provinceId = DecodeOriginal(source, ProvinceField, 0);
+        if(baronyTitle->GetProvinceId() != provinceId)
+            patches.push_back(source.PatchField(ProvinceField, "province", fmt::format("{}", baronyTitle->GetProvinceId())));
+        return;
+    }
+
+    SharedPtr<HighTitle> highTitle = CastSharedPtr<HighTitle>(title);
+
+    if(!title->Is(TitleType::COUNTY) && highTitle->GetCapitalTitle() != nullptr) {
+        Symbol capital = DecodeOriginal(source, CapitalField, Symbol());
+        if(highTitle->GetCapitalTitle()->GetName() != capital.Str())
+            patches.push_back(source.PatchField(CapitalField, "capital", highTitle->GetCapitalTitle()->GetName()));
+    }
+
+    for(const auto& dejureTitle : highTitle->GetDejureTitles())
+        this->PatchTitle(dejureTitle, patches);
 }
 
-Parser::Node Mod::ExportTitle(const SharedPtr<Title>& title, int depth) {
+Parser::Node Mod::ExportTitle(const SharedPtr<Title>& title) {
     Parser::Node data = (title->GetOriginalData() == nullptr) ? Parser::Node() : *title->GetOriginalData();
     
     data.Put("color", title->GetColor());
 
+    // The landless flag is decoded when loading and isn't in the original data.
+    if(title->IsLandless())
+        data.Put("landless", true);
+
     if(title->Is(TitleType::BARONY)) {
         SharedPtr<BaronyTitle> baronyTitle = CastSharedPtr<BaronyTitle>(title);
         data.Put("province", (double) baronyTitle->GetProvinceId());
@@ -782,10 +887,9 @@ Parser::Node Mod::ExportTitle(const SharedPtr<Title>& title, int depth) {
             data.Put("capital", highTitle->GetCapitalTitle()->GetName());
 
         for(const auto& dejureTitle : highTitle->GetDejureTitles()) {
-            data.Put(dejureTitle->GetName(), this->ExportTitle(dejureTitle, depth+1));
+            data.Put(dejureTitle->GetName(), this->ExportTitle(dejureTitle));
         }
     }
 
-    data.SetDepth(depth);
     return data;
 }
\ No newline at end of file
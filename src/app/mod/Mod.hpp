@@ -1,15 +1,24 @@
 #pragma once
 
+#include "app/map/CompactImage.hpp"
+#include "app/map/ProvinceRaster.hpp"
+#include "parser/Diagnostics.hpp"
+
 class Mod {
+friend TitlesLoader;
+friend ProvincesHistoryLoader;
 public:
     Mod(const std::string& dir);
 
     std::string GetDir() const;
-    sf::Image& GetHeightmapImage();
-    sf::Image& GetProvinceImage();
-    sf::Image& GetRiversImage();
-    sf::Image GetTitleImage(TitleType type);
+    // Images rebuilt from the compact copies kept in memory, to upload them.
+    // In low memory mode, the copies are dropped once the images are built,
+    // and are read again from their file when needed.
+    sf::Image GetHeightmapImage();
+    sf::Image GetRiversImage();
+    const ProvinceRaster& GetProvinceRaster() const;
     bool HasMap() const;
+    const Parser::Diagnostics& GetDiagnostics() const;
 
     std::map<uint32_t, SharedPtr<Province>>& GetProvinces();
     std::map<int, SharedPtr<Province>>& GetProvincesByIds();
@@ -17,13 +26,18 @@ public:
     SharedPtr<Title> GetProvinceFocusedTitle(const SharedPtr<Province>& province, TitleType type);
     int GetMaxProvinceId() const;
 
-    std::map<std::string, SharedPtr<Title>>& GetTitles();
+    std::map<Symbol, SharedPtr<Title>, Symbol::LexicalLess>& GetTitles();
     std::map<TitleType, std::vector<SharedPtr<Title>>>& GetTitlesByType();
 
+    // Remove the title from the mod and from its liege and vassals. Its
+    // original entry is removed from its file when exporting.
+    void DeleteTitle(const SharedPtr<Title>& title);
     void HarmonizeTitlesColors(const std::vector<SharedPtr<Title>>& titles, sf::Color color, float hue, float saturation);
     void GenerateMissingProvinces();
 
     void Load();
+    void LoadHeightmapImage();
+    void LoadRiversImage();
     void LoadProvinceImage();
     void LoadDefaultMapFile();
     void LoadProvincesDefinition();
@@ -32,7 +46,7 @@ public:
     void LoadTitles();
     void LoadTitlesHistory();
 
-    std::vector<SharedPtr<Title>> ParseTitles(const std::string& filePath, Parser::Node& data);
+    void ResolveTitlesCapitals();
 
     void Export();
     void ExportDefaultMapFile();
@@ -41,21 +55,43 @@ public:
     void ExportProvincesHistory();
     void ExportTitles();
 
-    Parser::Node ExportTitle(const SharedPtr<Title>& title, int depth);
+    Parser::Node ExportProvinceHistory(const SharedPtr<Province>& province);
+    Parser::Node ExportTitle(const SharedPtr<Title>& title);
+    // The patches are those of every file, since the values of a province may
+    // come from the entries of the files loaded before its last one.
+    void PatchProvinceHistory(const SharedPtr<Province>& province, std::map<std::string, std::vector<Parser::Patch>>& patches);
+    void PatchTitle(const SharedPtr<Title>& title, std::vector<Parser::Patch>& patches);
+
+private:
+    // Visit the files to load the provinces history or the titles, or only to
+    // reload their sources once the files have been written. VisitTitles
+    // returns the number of files visited.
+    void VisitProvincesHistory(Parser::Diagnostics& diagnostics, bool reload);
+    std::size_t VisitTitles(Parser::Diagnostics& diagnostics, bool reload);
 
 private:
     std::string m_Dir;
-    sf::Image m_HeightmapImage;
-    sf::Image m_ProvinceImage;
-    sf::Image m_RiversImage;
+    GrayscaleImage m_HeightmapImage;
+    PaletteImage m_RiversImage;
+    ProvinceRaster m_ProvinceRaster;
 
     std::map<uint32_t, SharedPtr<Province>> m_Provinces;
     std::map<int, SharedPtr<Province>> m_ProvincesByIds;
     
-    std::map<std::string, SharedPtr<Title>> m_Titles;
+    std::map<Symbol, SharedPtr<Title>, Symbol::LexicalLess> m_Titles;
     std::map<TitleType, std::vector<SharedPtr<Title>>> m_TitlesByType;
+    // Titles deleted in the editor which were loaded from a file.
+    std::vector<SharedPtr<Title>> m_DeletedTitles;
+
+    // Capitals are resolved once all the titles are loaded
+    // since they may be defined in another file.
+    std::vector<std::pair<SharedPtr<HighTitle>, Symbol>> m_UnresolvedCapitals;
 
     TerrainType m_DefaultLandTerrain;
     TerrainType m_DefaultSeaTerrain;
     TerrainType m_DefaultCoastalSeaTerrain;
+
+    // Problems found in the files of the mod while loading it,
+    // which are logged together once everything is loaded.
+    Parser::Diagnostics m_Diagnostics;
 };
\ No newline at end of file
@@ -1,11 +1,14 @@
 #include "app/App.hpp"
-#include "parser/Parser.hpp"
 
-int main() {
+int main(int argc, char** argv) {
+    for(int i = 1; i < argc; i++) {
+        if(std::string(argv[i]) == "--low-memory")
+            Configuration::lowMemory = true;
+    }
+
     App app;
     app.Init();
     app.DebugSettings();
     app.Run();
-    // Parser::Benchmark();
     return 0;
 }
\ No newline at end of file
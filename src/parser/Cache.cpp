@@ -0,0 +1,132 @@
+#include "Cache.hpp"
+#include "Diagnostics.hpp"
+
+#include <filesystem>
+#include <thread>
+#include <unistd.h>
+
+using namespace Parser;
+
+static constexpr char CacheMagic[8] = { 'M', 'E', 'C', 'K', 'T', 'T', 'O', 'K' };
+
+// Tokens are written and read back as raw bytes.
+static_assert(std::is_trivially_copyable_v<CompactToken>);
+
+Cache::Cache(const std::string& modDir)
+: m_Dir(modDir) {}
+
+UniquePtr<TokenStream> Cache::GetTokens(const std::string& filePath, std::string_view content) const {
+    std::error_code error;
+    int64_t time = std::filesystem::last_write_time(filePath, error).time_since_epoch().count();
+    std::string relativePath = this->GetRelativePath(filePath);
+    std::string entryPath = this->GetEntryPath(relativePath);
+    std::vector<CompactToken> tokens;
+
+    if(!error && this->Read(entryPath, relativePath, content, time, tokens))
+        return MakeUnique<TokenStream>(content, std::move(tokens));
+
+    // Files with problems aren't saved, so that they
+    // are reported again the next time they are loaded.
+    Diagnostics diagnostics;
+    {
+        const Diagnostics::Scope* current = Diagnostics::Scope::Current();
+        Diagnostics::Scope scope(&diagnostics, current ? current->GetFilePath() : filePath);
+        tokens = LexCompact(content);
+    }
+    diagnostics.Forward();
+
+    if(!error && diagnostics.Empty())
+        this->Write(entryPath, relativePath, content, time, tokens);
+    return MakeUnique<TokenStream>(content, std::move(tokens));
+}
+
+std::string Cache::GetRelativePath(const std::string& filePath) const {
+    return filePath.starts_with(m_Dir) ? filePath.substr(m_Dir.size()) : filePath;
+}
+
+std::string Cache::GetEntryPath(const std::string& relativePath) const {
+    return fmt::format("{}/{}/{:016x}.tokens", m_Dir, DirName, Hash(relativePath));
+}
+
+bool Cache::Read(const std::string& entryPath, const std::string& relativePath, std::string_view content, int64_t time, std::vector<CompactToken>& tokens) const {
+    File::MappedFile entry(entryPath);
+    std::string_view data = entry.GetContent();
+
+    if(data.size() < sizeof(Header))
+        return false;
+
+    Header header;
+    std::memcpy(&header, data.data(), sizeof(Header));
+
+    if(std::memcmp(header.magic, CacheMagic, sizeof(CacheMagic)) != 0 || header.version != Version)
+        return false;
+    if(data.size() != sizeof(Header) + header.pathLength + header.tokensCount * sizeof(CompactToken))
+        return false;
+    if(data.substr(sizeof(Header), header.pathLength) != relativePath || header.size != content.size())
+        return false;
+
+    // The file may have been touched without being modified,
+    // in which case the entry is still valid with the new time.
+    if(header.time != time) {
+        if(header.hash != Hash(content))
+            return false;
+
+        header.time = time;
+        std::fstream file(entryPath, std::ios::in | std::ios::out | std::ios::binary);
+        file.write((const char*) &header, sizeof(Header));
+    }
+
+    tokens.resize(header.tokensCount);
+    std::memcpy(tokens.data(), data.data() + sizeof(Header) + header.pathLength, header.tokensCount * sizeof(CompactToken));
+
+    // Never trust a corrupted entry with the text of its tokens.
+    for(const CompactToken& token : tokens) {
+        if((uint64_t) token.offset + token.length > content.size())
+            return false;
+    }
+    return true;
+}
+
+void Cache::Write(const std::string& entryPath, const std::string& relativePath, std::string_view content, int64_t time, const std::vector<CompactToken>& tokens) const {
+    std::error_code error;
+    std::filesystem::create_directories(m_Dir + "/" + DirName, error);
+    if(error)
+        return;
+
+    Header header;
+    std::memcpy(header.magic, CacheMagic, sizeof(CacheMagic));
+    header.version = Version;
+    header.pathLength = relativePath.size();
+    header.size = content.size();
+    header.time = time;
+    header.hash = Hash(content);
+    header.tokensCount = tokens.size();
+
+    // Write a temporary file first so that a partially written entry is never
+    // read by another instance. Its name is unique to the process and the thread,
+    // so that two instances writing the same entry don't write the same file.
+    std::size_t thread = std::hash<std::thread::id>()(std::this_thread::get_id());
+    std::string tmpPath = fmt::format("{}.{}-{:x}.tmp", entryPath, getpid(), thread);
+    std::ofstream file(tmpPath, std::ios::out | std::ios::binary);
+    file.write((const char*) &header, sizeof(Header));
+    file.write(relativePath.data(), relativePath.size());
+    file.write((const char*) tokens.data(), tokens.size() * sizeof(CompactToken));
+    file.close();
+
+    if(!file) {
+        std::filesystem::remove(tmpPath, error);
+        return;
+    }
+    std::filesystem::rename(tmpPath, entryPath, error);
+}
+
+uint64_t Cache::Hash(std::string_view content) {
+    // 64-bit FNV-1a, which is stable across platforms and
+    // library versions, unlike std::hash.
+    uint64_t hash = 0xcbf29ce484222325;
+    for(unsigned char ch : content) {
+        hash ^= ch;
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
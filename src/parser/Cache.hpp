@@ -0,0 +1,49 @@
+#pragma once
+
+#include "parser/Lexer.hpp"
+
+namespace Parser {
+    // On-disk cache of the tokens of the files of a mod, so that unchanged
+    // files don't have to be lexed again each time the mod is opened.
+    // Each file has its own entry in the .meckt-cache directory of the mod.
+    // An entry is used as is if the size and the modification time of the
+    // file didn't change, or if its content still has the same hash.
+    // The cache is only an optimization: entries which can't be
+    // read or written are silently ignored.
+    class Cache {
+    public:
+        // Increase it each time the tokens, the lexer or the entries change.
+        static constexpr uint32_t Version = 3;
+        static constexpr const char* DirName = ".meckt-cache";
+
+        Cache(const std::string& modDir);
+
+        // Return the tokens of the file from the cache if it is up to date,
+        // otherwise lex the content and save the tokens for the next time.
+        // The content must outlive the returned stream.
+        UniquePtr<TokenStream> GetTokens(const std::string& filePath, std::string_view content) const;
+
+    private:
+        struct Header {
+            char magic[8];
+            uint32_t version;
+            uint32_t pathLength;
+            uint64_t size;
+            int64_t time;
+            uint64_t hash;
+            uint64_t tokensCount;
+        };
+
+        // Entries are keyed by the path relative to the mod
+        // directory, so that the mod can be moved elsewhere.
+        std::string GetRelativePath(const std::string& filePath) const;
+        std::string GetEntryPath(const std::string& relativePath) const;
+        bool Read(const std::string& entryPath, const std::string& relativePath, std::string_view content, int64_t time, std::vector<CompactToken>& tokens) const;
+        void Write(const std::string& entryPath, const std::string& relativePath, std::string_view content, int64_t time, const std::vector<CompactToken>& tokens) const;
+
+        static uint64_t Hash(std::string_view content);
+
+    private:
+        std::string m_Dir;
+    };
+}
@@ -0,0 +1,139 @@
+#include "Diagnostics.hpp"
+#include "Scan.hpp"
+
+using namespace Parser;
+
+////////////////////////////////
+//        Scope class         //
+////////////////////////////////
+
+static thread_local const Diagnostics::Scope* s_CurrentScope = nullptr;
+
+Diagnostics::Scope::Scope(Diagnostics* diagnostics, std::string filePath) :
+    m_Diagnostics(diagnostics),
+    m_FilePath(std::move(filePath)),
+    m_Previous(s_CurrentScope)
+{
+    s_CurrentScope = this;
+}
+
+Diagnostics::Scope::Scope(const Scope* scope) :
+    m_Diagnostics(scope ? scope->m_Diagnostics : nullptr),
+    m_FilePath(scope ? scope->m_FilePath : std::string()),
+    m_Previous(s_CurrentScope)
+{
+    s_CurrentScope = this;
+}
+
+Diagnostics::Scope::~Scope() {
+    s_CurrentScope = m_Previous;
+}
+
+Diagnostics* Diagnostics::Scope::GetDiagnostics() const {
+    return m_Diagnostics;
+}
+
+const std::string& Diagnostics::Scope::GetFilePath() const {
+    return m_FilePath;
+}
+
+const Diagnostics::Scope* Diagnostics::Scope::Current() {
+    return s_CurrentScope;
+}
+
+////////////////////////////////
+//     Diagnostics class      //
+////////////////////////////////
+
+Diagnostics::Diagnostics() {}
+
+void Diagnostics::Add(Diagnostic diagnostic) {
+    std::lock_guard lock(m_Mutex);
+    m_Diagnostics.push_back(std::move(diagnostic));
+}
+
+void Diagnostics::Forward() const {
+    const Scope* scope = Scope::Current();
+    Diagnostics* sink = scope ? scope->GetDiagnostics() : nullptr;
+
+    for(const Diagnostic& diagnostic : this->Get()) {
+        if(sink != nullptr)
+            sink->Add(diagnostic);
+        else if(diagnostic.severity == Diagnostic::Severity::ERROR)
+            throw std::runtime_error("error: " + Format(diagnostic));
+    }
+}
+
+std::vector<Diagnostic> Diagnostics::Get() const {
+    std::vector<Diagnostic> diagnostics;
+    {
+        std::lock_guard lock(m_Mutex);
+        diagnostics = m_Diagnostics;
+    }
+
+    // Diagnostics reported by several threads are added in any order,
+    // and the tail of a chunk may be lexed again with the next one.
+    auto location = [](const Diagnostic& d) {
+        return std::tie(d.filePath, d.line, d.column, d.message);
+    };
+    std::stable_sort(diagnostics.begin(), diagnostics.end(), [&](const Diagnostic& a, const Diagnostic& b) {
+        return location(a) < location(b);
+    });
+    diagnostics.erase(std::unique(diagnostics.begin(), diagnostics.end(), [&](const Diagnostic& a, const Diagnostic& b) {
+        return location(a) == location(b);
+    }), diagnostics.end());
+    return diagnostics;
+}
+
+bool Diagnostics::Empty() const {
+    std::lock_guard lock(m_Mutex);
+    return m_Diagnostics.empty();
+}
+
+bool Diagnostics::HasErrors() const {
+    std::lock_guard lock(m_Mutex);
+    return std::any_of(m_Diagnostics.begin(), m_Diagnostics.end(), [](const Diagnostic& diagnostic) {
+        return diagnostic.severity == Diagnostic::Severity::ERROR;
+    });
+}
+
+void Diagnostics::Log() const {
+    for(const Diagnostic& diagnostic : this->Get()) {
+        if(diagnostic.severity == Diagnostic::Severity::ERROR)
+            ERROR("{}", Format(diagnostic));
+        else
+            WARNING("{}", Format(diagnostic));
+    }
+}
+
+void Diagnostics::Report(std::string_view content, std::size_t offset, Diagnostic::Severity severity, std::string_view message) {
+    Diagnostic diagnostic{severity, std::string(), 0, 0, std::string(message)};
+
+    // The location is only computed for the problems found.
+    if(offset <= content.size()) {
+        const char* begin = content.data();
+        std::size_t lineStart = (offset == 0) ? std::string_view::npos : content.rfind('\n', offset - 1);
+        lineStart = (lineStart == std::string_view::npos) ? 0 : lineStart + 1;
+        diagnostic.line = 1 + Scan::CountNewLines(begin, begin + offset);
+        diagnostic.column = 1 + offset - lineStart;
+    }
+
+    const Scope* scope = Scope::Current();
+    if(scope != nullptr && scope->GetDiagnostics() != nullptr) {
+        diagnostic.filePath = scope->GetFilePath();
+        scope->GetDiagnostics()->Add(std::move(diagnostic));
+        return;
+    }
+    if(severity == Diagnostic::Severity::ERROR)
+        throw std::runtime_error("error: " + Format(diagnostic));
+}
+
+std::string Diagnostics::Format(const Diagnostic& diagnostic) {
+    std::string location = diagnostic.filePath;
+    if(diagnostic.line > 0)
+        location += fmt::format("{}{}:{}", location.empty() ? "line " : ":", diagnostic.line, diagnostic.column);
+
+    if(location.empty())
+        return diagnostic.message;
+    return fmt::format("{}: {}", location, diagnostic.message);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <mutex>
+
+namespace Parser {
+    struct Diagnostic {
+        enum class Severity {
+            // Ignored when there isn't any sink, such as invalid characters.
+            WARNING,
+            // Thrown when there isn't any sink.
+            ERROR,
+        };
+
+        Severity severity;
+        std::string filePath;
+        // Both start at 1, or are 0 if the location is unknown. Lines of inputs
+        // read from a stream are counted from the window kept in memory.
+        uint line;
+        uint column;
+        std::string message;
+    };
+
+    // Collect the problems found by the lexer and the parser instead of
+    // stopping at the first one. They are reported to the sink installed on
+    // the current thread by a Scope, and the parsing goes on after skipping
+    // the faulty tokens. Without any sink, errors are thrown as before.
+    // A same sink can be used by several threads at once.
+    class Diagnostics {
+        public:
+            class Scope {
+                public:
+                    Scope(Diagnostics* diagnostics, std::string filePath);
+                    // Install the sink and the file of another scope, such as that
+                    // of the thread which started a parallel task, or no sink if null.
+                    Scope(const Scope* scope);
+                    Scope(const Scope&) = delete;
+                    ~Scope();
+
+                    Diagnostics* GetDiagnostics() const;
+                    const std::string& GetFilePath() const;
+
+                    static const Scope* Current();
+
+                private:
+                    Diagnostics* m_Diagnostics;
+                    std::string m_FilePath;
+                    const Scope* m_Previous;
+            };
+
+            Diagnostics();
+            Diagnostics(const Diagnostics&) = delete;
+
+            void Add(Diagnostic diagnostic);
+            // Add the diagnostics to the sink of the current thread,
+            // or throw the first error if there isn't any.
+            void Forward() const;
+
+            // Sorted by file and location, without duplicates.
+            std::vector<Diagnostic> Get() const;
+            bool Empty() const;
+            bool HasErrors() const;
+            void Log() const;
+
+            // Report a problem at the offset of the content.
+            static void Report(std::string_view content, std::size_t offset, Diagnostic::Severity severity, std::string_view message);
+            static std::string Format(const Diagnostic& diagnostic);
+
+        private:
+            mutable std::mutex m_Mutex;
+            std::vector<Diagnostic> m_Diagnostics;
+    };
+}
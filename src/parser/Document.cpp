@@ -0,0 +1,100 @@
+#include "Document.hpp"
+#include "Diagnostics.hpp"
+
+using namespace Parser;
+
+////////////////////////////////
+//       Document class       //
+////////////////////////////////
+
+Document::Document(std::string filePath, std::string content)
+: m_FilePath(std::move(filePath)), m_Content(std::move(content)) {}
+
+const std::string& Document::GetFilePath() const {
+    return m_FilePath;
+}
+
+std::string_view Document::GetContent() const {
+    return m_Content;
+}
+
+std::string_view Document::GetText(Span span) const {
+    return std::string_view(m_Content).substr(span.offset, span.length);
+}
+
+void Document::Write(std::ostream& stream, std::vector<Patch> patches) const {
+    std::stable_sort(patches.begin(), patches.end(), [](const Patch& a, const Patch& b) {
+        return a.span.offset < b.span.offset;
+    });
+
+    // The text between two patches is written in a single call.
+    std::size_t cursor = 0;
+    for(const Patch& patch : patches) {
+        if(patch.span.offset < cursor || patch.span.End() > m_Content.size())
+            continue;
+        stream.write(m_Content.data() + cursor, patch.span.offset - cursor);
+        stream.write(patch.text.data(), patch.text.size());
+        cursor = patch.span.End();
+    }
+    stream.write(m_Content.data() + cursor, m_Content.size() - cursor);
+}
+
+////////////////////////////////
+//        Source struct       //
+////////////////////////////////
+
+Patch Source::PatchField(std::size_t field, std::string_view key, std::string_view value) const {
+    if(!fields[field].Empty())
+        return Patch{fields[field], std::string(value)};
+
+    // The closing brace of the entry is its last token. The entry has already
+    // been lexed when loading it, so its problems have already been reported.
+    std::string_view content = document->GetContent();
+    std::vector<CompactToken> tokens;
+    {
+        Diagnostics diagnostics;
+        Diagnostics::Scope scope(&diagnostics, document->GetFilePath());
+        LexCompact(content.substr(0, span.End()), span.offset, true, tokens);
+    }
+    std::size_t end = span.End();
+    if(!tokens.empty() && tokens.back().Is(TokenType::RIGHT_BRACE))
+        end = tokens.back().offset;
+
+    // Insert the field on its own line if the closing brace of the entry
+    // is on its own line too, with the same line ending, or right before it otherwise.
+    std::size_t previous = content.find_last_not_of(" \t", end - 1);
+
+    if(previous != std::string_view::npos && content[previous] == '\n') {
+        uint32_t lineStart = previous + 1;
+        std::string_view newline = (previous > 0 && content[previous - 1] == '\r') ? "\r\n" : "\n";
+        return Patch{Span{lineStart, 0}, fmt::format("{}{} = {}{}", std::string(depth + 1, '\t'), key, value, newline)};
+    }
+    return Patch{Span{(uint32_t) end, 0}, fmt::format("{} = {} ", key, value)};
+}
+
+Patch Source::RemoveField(std::size_t field) const {
+    std::string_view content = document->GetContent();
+    std::size_t end = fields[field].End();
+
+    // The key is right before the value, separated by the operator.
+    std::size_t keyEnd = content.find_last_not_of(" \t\r\n", fields[field].offset - 1);
+    keyEnd = content.find_last_not_of("=<>!?", keyEnd);
+    keyEnd = content.find_last_not_of(" \t\r\n", keyEnd);
+    std::size_t start = content.find_last_of(" \t\r\n{", keyEnd) + 1;
+
+    std::size_t lineStart = (start == 0) ? std::string_view::npos : content.find_last_not_of(" \t", start - 1);
+    std::size_t lineEnd = content.find_first_not_of(" \t\r", end);
+    bool startsLine = (lineStart == std::string_view::npos || content[lineStart] == '\n');
+    bool endsLine = (lineEnd == std::string_view::npos || content[lineEnd] == '\n');
+
+    if(startsLine && endsLine) {
+        start = (lineStart == std::string_view::npos) ? 0 : lineStart + 1;
+        end = (lineEnd == std::string_view::npos) ? content.size() : lineEnd + 1;
+    }
+    else {
+        end = content.find_first_not_of(" \t", end);
+        if(end == std::string_view::npos)
+            end = content.size();
+    }
+    return Patch{Span{(uint32_t) start, (uint32_t) (end - start)}, ""};
+}
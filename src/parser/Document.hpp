@@ -0,0 +1,55 @@
+#pragma once
+
+#include "parser/Lexer.hpp"
+
+namespace Parser {
+    // Replace the text of a span, or insert it if the span is empty.
+    struct Patch {
+        Span span;
+        std::string text;
+    };
+
+    // Original content of a parsed file, kept so that it can be written back
+    // with only some of its spans replaced. Everything else, including the
+    // comments and the order of the entries, is copied through as is.
+    class Document {
+    public:
+        Document(std::string filePath, std::string content);
+        Document(const Document&) = delete;
+
+        const std::string& GetFilePath() const;
+        std::string_view GetContent() const;
+        std::string_view GetText(Span span) const;
+
+        // Write the content with the patches applied. A patch overlapping
+        // a previous one is ignored, such as a value inside an entry which
+        // is replaced as a whole.
+        void Write(std::ostream& stream, std::vector<Patch> patches) const;
+
+    private:
+        std::string m_FilePath;
+        std::string m_Content;
+    };
+
+    // Location of an entry in its original document: the span of the whole
+    // "key = { ... }" entry and those of some of its values, by field index.
+    // Values which weren't in the entry have an empty span.
+    struct Source {
+        SharedPtr<Document> document;
+        Span span;
+        uint depth = 0;
+        std::vector<Span> fields;
+        // Number of entries nested in this one which have their own source.
+        uint childrenCount = 0;
+        // Entry of the same object in a file loaded before, for the
+        // values which aren't overridden by this entry.
+        SharedPtr<Source> previous;
+
+        // Replace the value of the field, or insert it before the
+        // end of the entry block if it wasn't in the entry.
+        Patch PatchField(std::size_t field, std::string_view key, std::string_view value) const;
+        // Remove the whole "key = value" entry of the field, which must be in
+        // the entry, along with its line if there is nothing else on it.
+        Patch RemoveField(std::size_t field) const;
+    };
+}
@@ -1,167 +1,484 @@
 #include "Lexer.hpp"
+#include "Diagnostics.hpp"
+#include <array>
+#include <charconv>
+#include <limits>
 
-using Parser::PToken;
-using Parser::TokenValue;
 using Parser::TokenType;
-using Parser::Token;
 
-Token::Token(TokenType type)
-: Token(type, (PToken) nullptr) {}
+////////////////////////////////
+//     Character classes      //
+////////////////////////////////
 
-Token::Token(TokenType type, TokenValue value)
-: m_Type(type), m_Value(value) {}
+namespace {
+    enum CharClass : uint8_t {
+        INVALID,
+        WHITESPACE,
+        DIGIT,
+        // Letters, '_', '$' and the bytes of UTF-8 characters.
+        LETTER,
+        DOT,
+        MINUS,
+        AT,
+        QUOTE,
+        HASH,
+        LEFT_BRACE,
+        RIGHT_BRACE,
+        COLON,
+        EQUAL,
+        LESS,
+        GREATER,
+        EXCLAMATION,
+        QUESTION,
+        CHAR_CLASSES_COUNT
+    };
 
-Token::Token(const Token& token)
-: Token(token.GetType(), token.GetValue()) {}
+    constexpr std::array<CharClass, 256> MakeCharClasses() {
+        std::array<CharClass, 256> classes{};
+        for(int ch = 0; ch < 256; ch++) {
+            if(ch >= '0' && ch <= '9')
+                classes[ch] = DIGIT;
+            else if((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_' || ch == '$' || ch >= 0x80)
+                classes[ch] = LETTER;
+        }
+        classes[' '] = classes['\t'] = classes['\r'] = classes['\n'] = WHITESPACE;
+        classes['.'] = DOT;
+        classes['-'] = MINUS;
+        classes['@'] = AT;
+        classes['"'] = QUOTE;
+        classes['#'] = HASH;
+        classes['{'] = LEFT_BRACE;
+        classes['}'] = RIGHT_BRACE;
+        classes[':'] = COLON;
+        classes['='] = EQUAL;
+        classes['<'] = LESS;
+        classes['>'] = GREATER;
+        classes['!'] = EXCLAMATION;
+        classes['?'] = QUESTION;
+        return classes;
+    }
 
-Token::~Token() {}
+    constexpr std::array<CharClass, 256> CharClasses = MakeCharClasses();
 
-TokenType Token::GetType() const {
-    return m_Type;
-}
+    // States of the automaton reading numbers, dates and identifiers
+    // such as: 12, -0.5, 1066.9.15, k_france, @variable.
+    enum WordState : uint8_t {
+        START,
+        SIGN,
+        INTEGER,
+        POINT,
+        DECIMAL,
+        SECOND_POINT,
+        DAY,
+        IDENTIFIER,
+        // The character isn't part of the word anymore.
+        END,
+        WORD_STATES_COUNT
+    };
+
+    constexpr std::array<std::array<WordState, CHAR_CLASSES_COUNT>, WORD_STATES_COUNT> MakeWordTransitions() {
+        std::array<std::array<WordState, CHAR_CLASSES_COUNT>, WORD_STATES_COUNT> transitions{};
+        for(auto& row : transitions)
+            row.fill(END);
+
+        auto set = [&](WordState state, WordState digit, WordState dot, WordState letter) {
+            transitions[state][DIGIT] = digit;
+            transitions[state][DOT] = dot;
+            transitions[state][LETTER] = letter;
+        };
+        set(START, INTEGER, END, IDENTIFIER);
+        set(SIGN, INTEGER, IDENTIFIER, IDENTIFIER);
+        set(INTEGER, INTEGER, POINT, IDENTIFIER);
+        set(POINT, DECIMAL, IDENTIFIER, IDENTIFIER);
+        set(DECIMAL, DECIMAL, SECOND_POINT, IDENTIFIER);
+        set(SECOND_POINT, DAY, IDENTIFIER, IDENTIFIER);
+        set(DAY, DAY, IDENTIFIER, IDENTIFIER);
+        set(IDENTIFIER, IDENTIFIER, IDENTIFIER, IDENTIFIER);
+
+        // A minus sign or an at sign can only start a word.
+        transitions[START][MINUS] = SIGN;
+        transitions[START][AT] = IDENTIFIER;
+        return transitions;
+    }
+
+    constexpr std::array<std::array<WordState, CHAR_CLASSES_COUNT>, WORD_STATES_COUNT> WordTransitions = MakeWordTransitions();
+
+    CharClass GetClass(char ch) {
+        return CharClasses[(uint8_t) ch];
+    }
 
-bool Token::Is(TokenType type) const {
-    return m_Type == type;
+    bool IsColorPrefix(std::string_view str) {
+        return str == "rgb" || str == "hsv" || str == "hsv360";
+    }
 }
 
-TokenValue Token::GetValue() const {
-    return m_Value;
+std::vector<Parser::Span> Parser::SplitEntries(std::string_view content, std::size_t chunkSize) {
+    std::vector<Span> chunks;
+    const char* begin = content.data();
+    const char* end = begin + content.size();
+    std::size_t start = 0;
+    std::size_t cursor = 0;
+    int depth = 0;
+
+    // Only the characters changing the depth are looked at. The lexer
+    // never reads braces inside strings and comments, nor a quote or a '#'
+    // inside another token, so the chunks end on the same tokens.
+    while((cursor = Scan::FindAny(begin + cursor, end, '{', '}', '"', '#') - begin) < content.size()) {
+        char ch = content[cursor++];
+
+        if(ch == '"' || ch == '#') {
+            cursor = Scan::Find(begin + cursor, end, (ch == '"') ? '"' : '\n') - begin;
+            if(cursor == content.size())
+                break;
+            cursor++;
+        }
+        else if(ch == '{') {
+            depth++;
+        }
+        // A closing brace without block ends the parsing, so everything
+        // after it is left in the last chunk.
+        else if(--depth < 0) {
+            break;
+        }
+        else if(depth == 0 && cursor - start >= chunkSize) {
+            chunks.push_back(Span{(uint32_t) start, (uint32_t) (cursor - start)});
+            start = cursor;
+        }
+    }
+
+    if(start < content.size() || chunks.empty())
+        chunks.push_back(Span{(uint32_t) start, (uint32_t) (content.size() - start)});
+    return chunks;
 }
 
-// TODO: add a function lex from a stringstream or ifstream.
+std::vector<Parser::CompactToken> Parser::LexCompact(std::string_view content) {
+    std::vector<CompactToken> tokens;
+
+    if(content.size() < 2 * ParallelChunkSize) {
+        // Rough estimation to avoid most of the reallocations.
+        tokens.reserve(content.size() / 6);
+        LexCompact(content, 0, true, tokens);
+        return tokens;
+    }
+
+    // Each chunk is lexed from its offset in the whole content,
+    // so the offsets of the tokens don't have to be shifted.
+    std::vector<Span> chunks = SplitEntries(content);
+    std::vector<std::vector<CompactToken>> chunksTokens(chunks.size());
+    const Diagnostics::Scope* diagnostics = Diagnostics::Scope::Current();
+
+    Parallel::For(chunks.size(), [&](std::size_t i) {
+        Diagnostics::Scope scope(diagnostics);
+        chunksTokens[i].reserve(chunks[i].length / 6);
+        LexCompact(content.substr(0, chunks[i].End()), chunks[i].offset, true, chunksTokens[i]);
+    });
 
-std::deque<PToken> Parser::Lex(const std::string& content) {
-    std::deque<PToken> tokens;
-    Reader reader(content);
+    std::size_t count = 0;
+    for(const auto& chunkTokens : chunksTokens)
+        count += chunkTokens.size();
+    tokens.reserve(count);
+    for(const auto& chunkTokens : chunksTokens)
+        tokens.insert(tokens.end(), chunkTokens.begin(), chunkTokens.end());
+
+    return tokens;
+}
+
+std::size_t Parser::LexCompact(std::string_view content, std::size_t start, bool last, std::vector<CompactToken>& tokens) {
+    // Skip the UTF-8 byte order mark written by some editors.
+    if(start == 0 && content.starts_with(ByteOrderMark))
+        start = ByteOrderMark.size();
+    Reader reader(content, start);
 
     while(!reader.IsEmpty()) {
-        // Save the cursor position.
+        reader.SkipWhitespaces();
+        if(reader.IsEmpty())
+            break;
         reader.Start();
-        PToken token = ReadToken(reader);
-        if(token != nullptr)
+        int tokenStart = reader.GetCursor();
+
+        // Wait for the next chunk if the string isn't closed yet.
+        if(!last && reader.Peek() == '"' && content.find('"', tokenStart + 1) == std::string_view::npos)
+            return tokenStart;
+
+        CompactToken token;
+        bool read = ReadToken(reader, token);
+
+        // Numbers, identifiers, comments and operators may be cut at the end
+        // of the chunk, so lex them again with the next one. So are color
+        // prefixes whose brace may only be in the next chunk.
+        if(!last && reader.IsEmpty())
+            return tokenStart;
+        if(!last && read && token.Is(TokenType::IDENTIFIER) && IsColorPrefix(content.substr(token.offset, token.length))
+            && Scan::SkipWhitespaces(content.data() + reader.GetCursor(), content.data() + content.size()) == content.data() + content.size())
+            return tokenStart;
+
+        // Comments are never used by the parser, so they are not kept.
+        if(read && !token.Is(TokenType::COMMENT))
             tokens.push_back(token);
     }
 
-    return tokens;
+    return reader.GetCursor();
 }
 
-PToken Parser::ReadToken(Reader& reader) {
-    char ch = reader.Advance();
-    // int line = reader.GetLine();
+// Characters which can't start any token are skipped.
+static bool SkipInvalid(Reader& reader) {
+    std::string_view text = reader.GetContent().substr(reader.GetStart(), 1);
+    Parser::Diagnostics::Report(reader.GetContent(), reader.GetStart(), Parser::Diagnostic::Severity::WARNING, fmt::format("unexpected character '{}'", text));
+    return false;
+}
 
-    // TODO: handle UTF8 characters
-    // and ZERO WIDTH NO-BREAK SPACE
+bool Parser::ReadToken(Reader& reader, CompactToken& token) {
+    char ch = reader.Advance();
 
-    switch(ch) {
-        // Ignore whitespaces.
-        case ' ':
-        case '\r':
-        case '\t':
-        case '\n':
+    switch(GetClass(ch)) {
+        case WHITESPACE:
+            return false;
+        case LEFT_BRACE: token.type = TokenType::LEFT_BRACE; break;
+        case RIGHT_BRACE: token.type = TokenType::RIGHT_BRACE; break;
+        case COLON: token.type = TokenType::TWO_DOTS; break;
+        case EQUAL: token.type = TokenType::EQUAL; break;
+        case LESS: token.type = reader.Match('=') ? TokenType::LESS_EQUAL : TokenType::LESS; break;
+        case GREATER: token.type = reader.Match('=') ? TokenType::GREATER_EQUAL : TokenType::GREATER; break;
+        case EXCLAMATION:
+            if(!reader.Match('='))
+                return SkipInvalid(reader);
+            token.type = TokenType::NOT_EQUAL;
+            break;
+        case QUESTION:
+            if(!reader.Match('='))
+                return SkipInvalid(reader);
+            token.type = TokenType::QUESTION_EQUAL;
             break;
-        case '{': return MakeShared<Token>(TokenType::LEFT_BRACE);
-        case '}': return MakeShared<Token>(TokenType::RIGHT_BRACE);
-        case ':': return MakeShared<Token>(TokenType::TWO_DOTS);
-        case '=': return MakeShared<Token>(TokenType::EQUAL);
-        case '<': return MakeShared<Token>(reader.Match('=') ? TokenType::LESS_EQUAL : TokenType::LESS);
-        case '>': return MakeShared<Token>(reader.Match('=') ? TokenType::GREATER_EQUAL : TokenType::GREATER);
-        case '#':
+        case HASH:
             // Ignore '#' in value of token.
             reader.Start();
             reader.SkipTo('\n');
-            return MakeShared<Token>(TokenType::COMMENT, reader.End());
-        case '"': return ReadString(reader);
-        default:
-            if(String::IsDigit(ch) || ch == '-') {
-                PToken token = ReadNumber(reader);
-                if(token != nullptr)
-                    return token;
-            }
-            if(String::IsAlphaNumeric(ch) || ch == '-') {
-                PToken token = ReadIdentifier(reader);
-                if(token != nullptr)
-                    return token;
+            token.type = TokenType::COMMENT;
+            break;
+        case QUOTE:
+            return ReadString(reader, token);
+        case AT:
+            // Inline math such as @[ x * 2 ] is kept as a single identifier.
+            if(reader.Peek() == '[') {
+                reader.SkipTo(']');
+                // Keep the rest of the content in the identifier.
+                if(reader.IsEmpty())
+                    Diagnostics::Report(reader.GetContent(), reader.GetStart(), Diagnostic::Severity::ERROR, "missing end of inline math");
+                else
+                    reader.Advance();
+                token.type = TokenType::IDENTIFIER;
+                break;
             }
-            // throw std::runtime_error(fmt::format("Unexpected character '{}' ({}) at line {}.", ch, (int) ch, line));
+            return ReadWord(reader, token);
+        case DIGIT:
+        case LETTER:
+        case MINUS:
+            return ReadWord(reader, token);
+        default:
+            return SkipInvalid(reader);
     }
-    return nullptr;
-}
 
-PToken Parser::ReadString(Reader& reader) {
-    // Save cursor to discard starting quote.
-    int line = reader.GetLine();
+    token.offset = reader.GetStart();
+    token.length = reader.GetCursor() - reader.GetStart();
+    return true;
+}
 
-    reader.Start();
+bool Parser::ReadString(Reader& reader, CompactToken& token) {
+    // The starting quote is kept in the token text.
+    int start = reader.GetStart();
     reader.SkipTo('"');
 
+    // The string goes on until the end of the content if it isn't closed.
     if(reader.IsEmpty())
-        throw std::runtime_error(fmt::format("Expected end-of-string quote missing at line at line {}.", line));
-
-    // Discard ending quote in token value.
-    std::string str = reader.End();
-    reader.Advance();
+        Diagnostics::Report(reader.GetContent(), start, Diagnostic::Severity::ERROR, "missing end-of-string quote");
+    else
+        reader.Advance();
 
-    return MakeShared<Token>(TokenType::STRING, "\"" + str + "\"");
+    token.type = TokenType::STRING;
+    token.offset = start;
+    token.length = reader.GetCursor() - start;
+    return true;
 }
 
-PToken Parser::ReadNumber(Reader& reader) {
-    // Check if it is a NUMBER:
-    // - only digits
-    // - allow one decimal '.'
+bool Parser::ReadWord(Reader& reader, CompactToken& token) {
+    // The first character has already been read by ReadToken.
+    std::string_view content = reader.GetContent();
+    std::size_t start = reader.GetStart();
+    std::size_t cursor = start;
 
-    while(String::IsDigit(reader.Peek()))
-        reader.Advance();
-    if(reader.Peek() == '.') {
-        reader.Advance();
+    // The parts of a date are decoded while reading the word,
+    // and are only used if it ends up being one. The decoding
+    // stops once a part is too large for a date.
+    constexpr int32_t MaxDatePart = std::numeric_limits<int16_t>::max();
+    WordState state = START;
+    int32_t parts[3] = { 0, 0, 0 };
+    int part = 0;
+    bool tooLarge = false;
+
+    while(cursor < content.size()) {
+        CharClass charClass = GetClass(content[cursor]);
+        WordState next = WordTransitions[state][charClass];
+        if(next == END)
+            break;
+
+        if(charClass == DIGIT && !tooLarge) {
+            parts[part] = parts[part] * 10 + (content[cursor] - '0');
+            tooLarge = (parts[part] > MaxDatePart);
+        }
+        else if(charClass == DOT && part < 2)
+            part++;
+        state = next;
+        cursor++;
+    }
+    reader.Skip(cursor - reader.GetCursor());
 
-        // Don't allow trailing floating points.
-        if(!String::IsDigit(reader.Peek()))
-            return nullptr;
+    std::string_view str = content.substr(start, cursor - start);
+    token.offset = start;
+    token.length = str.size();
 
-        while(String::IsDigit(reader.Peek()))
-            reader.Advance();
+    if(state == INTEGER || state == DECIMAL) {
+        auto [ptr, error] = std::from_chars(str.data(), str.data() + str.size(), token.number);
+        if(error == std::errc()) {
+            token.type = TokenType::NUMBER;
+            return true;
+        }
+    }
 
-        // Skip if number ends by a dot because it may be a date.
-        if(reader.Peek() == '.')
-            return nullptr;
+    if(state == DAY && !tooLarge) {
+        token.type = TokenType::DATE;
+        token.date = { str[0] == '-' ? -parts[0] : parts[0], (int16_t) parts[1], (int16_t) parts[2] };
+        return true;
     }
-    std::string str = reader.End();
-    return MakeShared<Token>(TokenType::NUMBER, std::stod(str));
-}
 
-PToken Parser::ReadIdentifier(Reader& reader) {
-    // An IDENTIFIER can have only have digits, letters, '.' and '_',
-    // whereas a BOOLEAN is either 'yes' or 'no',
-    // and a DATE is formatted as: yyyy.mm.dd
+    if(str == "yes" || str == "no") {
+        token.type = TokenType::BOOLEAN;
+        token.boolean = (str == "yes");
+        return true;
+    }
 
-    while(String::IsAlphaNumeric(reader.Peek()) || reader.Peek() == '.')
-        reader.Advance();
-    std::string str = reader.End();
-
-    // Check if the string is a valid boolean.
-    if(str == "yes" || str == "no")
-        return MakeShared<Token>(TokenType::BOOLEAN, str == "yes");
-
-    
-    // Check if the string is a valid date.
-    int dots = 0;
-    int firstIndex = str[0] == '-' ? 1 : 0;
-    for(int i = firstIndex; i < str.size(); i++) {
-        // A date cannot have the following:
-        // ".0000" or "0000."
-        // "*x*" with x a non-digit character
-        bool digit = String::IsDigit(str[i]);
-        if(((i == firstIndex || i == str.size()-1) && !digit)
-            || (!digit && str[i] != '.')
-            || (!digit && str[i] == '.' && str[i-1] == '.')) {
-            dots = 0;
-            break;
+    // Color prefixes are only recognized right before the block of the color,
+    // such as: color = hsv { 0.5 0.8 0.6 }
+    if(IsColorPrefix(str)) {
+        const char* begin = content.data();
+        const char* next = Scan::SkipWhitespaces(begin + cursor, begin + content.size());
+        if(next != begin + content.size() && *next == '{') {
+            token.type = TokenType::COLOR;
+            return true;
         }
-        if(str[i] == '.')
-            dots++;
     }
-    if(dots != 2)
-        return MakeShared<Token>(TokenType::IDENTIFIER, str);
 
-    return MakeShared<Token>(TokenType::DATE, Date(str));
-}
\ No newline at end of file
+    token.type = TokenType::IDENTIFIER;
+    return true;
+}
+
+////////////////////////////////
+//     TokenStream class      //
+////////////////////////////////
+
+Parser::TokenStream::TokenStream(std::string_view content)
+: m_Content(content), m_Tokens(LexCompact(content)), m_Cursor(0), m_Stream(nullptr), m_LexCursor(0), m_TokensCount(m_Tokens.size()) {}
+
+Parser::TokenStream::TokenStream(std::string_view content, std::vector<CompactToken>&& tokens)
+: m_Content(content), m_Tokens(std::move(tokens)), m_Cursor(0), m_Stream(nullptr), m_LexCursor(0), m_TokensCount(m_Tokens.size()) {}
+
+Parser::TokenStream::TokenStream(std::istream& stream)
+: m_Content(), m_Tokens(), m_Cursor(0), m_Stream(&stream), m_LexCursor(0), m_TokensCount(0) {}
+
+bool Parser::TokenStream::Empty() {
+    return !this->Has(1);
+}
+
+bool Parser::TokenStream::Has(std::size_t n) {
+    while(m_Tokens.size() - m_Cursor < n) {
+        if(!this->Fill())
+            return false;
+    }
+    return true;
+}
+
+Parser::CompactToken Parser::TokenStream::Peek(std::size_t n) {
+    if(!this->Has(n + 1))
+        return this->GetEndToken();
+    return m_Tokens[m_Cursor + n];
+}
+
+Parser::CompactToken Parser::TokenStream::Next() {
+    if(!this->Has(1))
+        return this->GetEndToken();
+    return m_Tokens[m_Cursor++];
+}
+
+std::string_view Parser::TokenStream::GetText(const CompactToken& token) const {
+    return m_Content.substr(token.offset, token.length);
+}
+
+std::string_view Parser::TokenStream::GetContent() const {
+    return m_Content;
+}
+
+std::size_t Parser::TokenStream::GetTokensCount() const {
+    return m_TokensCount;
+}
+
+std::size_t Parser::TokenStream::GetOffset() {
+    if(!this->Has(1))
+        return m_Content.size();
+    return m_Tokens[m_Cursor].offset;
+}
+
+std::size_t Parser::TokenStream::GetEnd() const {
+    if(m_Cursor == 0)
+        return 0;
+    const CompactToken& token = m_Tokens[m_Cursor - 1];
+    return token.offset + token.length;
+}
+
+void Parser::TokenStream::Discard() {
+    // Only the content read from an input stream is owned, in the buffer.
+    if(m_Content.data() != m_Buffer.data())
+        return;
+
+    // Drop the bytes before the first remaining token and rebase the offsets
+    // of the others, only once there is enough to drop to be worth the move.
+    std::size_t dropped = (m_Cursor < m_Tokens.size()) ? m_Tokens[m_Cursor].offset : m_LexCursor;
+    if(dropped < ChunkSize)
+        return;
+
+    m_Tokens.erase(m_Tokens.begin(), m_Tokens.begin() + m_Cursor);
+    m_Cursor = 0;
+    for(CompactToken& token : m_Tokens)
+        token.offset -= dropped;
+    m_Buffer.erase(0, dropped);
+    m_LexCursor -= dropped;
+    m_Content = m_Buffer;
+}
+
+Parser::CompactToken Parser::TokenStream::GetEndToken() const {
+    CompactToken token;
+    token.type = TokenType::END;
+    token.offset = m_Content.size();
+    token.length = 0;
+    token.number = 0;
+    return token;
+}
+
+bool Parser::TokenStream::Fill() {
+    if(m_Stream == nullptr)
+        return false;
+
+    // Append the next chunk to the bytes not lexed yet.
+    std::size_t size = m_Buffer.size();
+    m_Buffer.resize(size + ChunkSize);
+    m_Stream->read(m_Buffer.data() + size, ChunkSize);
+    m_Buffer.resize(size + m_Stream->gcount());
+
+    bool last = !m_Stream->good();
+    std::size_t count = m_Tokens.size();
+    m_LexCursor = LexCompact(m_Buffer, m_LexCursor, last, m_Tokens);
+    m_TokensCount += m_Tokens.size() - count;
+    m_Content = m_Buffer;
+
+    if(last)
+        m_Stream = nullptr;
+    return true;
+}
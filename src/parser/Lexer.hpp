@@ -2,9 +2,6 @@
 #include "Reader.hpp"
 
 namespace Parser {
-    using PToken = SharedPtr<Token>;
-    using TokenValue = std::variant<double, bool, std::string, Date, PToken>;
-
     enum class TokenType {
         // Separators / Punctuators
         LEFT_BRACE, RIGHT_BRACE, TWO_DOTS,
@@ -12,35 +9,131 @@ namespace Parser {
         // Operators
         EQUAL,
         LESS, LESS_EQUAL,
-        GREATER, GREATER_EQUAL, 
+        GREATER, GREATER_EQUAL,
+        NOT_EQUAL, QUESTION_EQUAL,
 
         // Literals
         STRING, NUMBER, BOOLEAN, DATE,
         
         // Others
-        COMMENT, IDENTIFIER
+        COMMENT, IDENTIFIER,
+        // Prefix of a color block: rgb, hsv or hsv360.
+        COLOR,
+        // Returned by a token stream past its last token, never lexed.
+        END
+    };
+
+    // Fixed-size token which doesn't own its text: the offset and
+    // length refer to the lexed buffer. Numbers, booleans and dates
+    // are decoded once by the lexer.
+    struct CompactDate {
+        int32_t year;
+        int16_t month;
+        int16_t day;
+    };
+
+    struct CompactToken {
+        TokenType type;
+        uint32_t offset;
+        uint32_t length;
+        union {
+            double number;
+            bool boolean;
+            CompactDate date;
+        };
+
+        bool Is(TokenType t) const { return type == t; }
+        Date GetDate() const { return Date(date.year, date.month, date.day); }
     };
 
-    class Token {
+    // Range of bytes of a lexed buffer, such as the text of a value.
+    struct Span {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+
+        uint32_t End() const { return offset + length; }
+        bool Empty() const { return length == 0; }
+    };
+
+    // Tokens of a whole buffer stored in one contiguous vector.
+    // The buffer (usually a File::MappedFile) must outlive the stream.
+    // A stream can also be lexed lazily from an input stream, chunk by chunk.
+    // The bytes and tokens already consumed are dropped by Discard, so only
+    // a small window of the input is kept in memory.
+    // Tokens are returned by value since reading a chunk may move them.
+    class TokenStream {
     public:
-        Token(TokenType type);
-        Token(TokenType type, TokenValue value);
-        Token(const Token& token);
-        ~Token();
+        static constexpr std::size_t ChunkSize = 64 * 1024;
+
+        TokenStream(std::string_view content);
+        // Tokens already lexed from the content.
+        TokenStream(std::string_view content, std::vector<CompactToken>&& tokens);
+        TokenStream(std::istream& stream);
+        TokenStream(const TokenStream&) = delete;
 
-        TokenType GetType() const;
-        bool Is(TokenType type) const;
-        TokenValue GetValue() const;
+        bool Empty();
+        // Check if there are at least n tokens left.
+        bool Has(std::size_t n);
+
+        // Past the last token, an END token at the end of the content is returned.
+        CompactToken Peek(std::size_t n = 0);
+        CompactToken Next();
+
+        std::string_view GetText(const CompactToken& token) const;
+        // Content the offsets of the tokens refer to, which is only
+        // the window kept in memory when reading from an input stream.
+        std::string_view GetContent() const;
+        std::size_t GetTokensCount() const;
+
+        // Offset of the next token, or the size of the content at the end.
+        std::size_t GetOffset();
+        // Offset right after the last token consumed.
+        // Offsets are only those of the content if it isn't read
+        // from an input stream, whose chunks are discarded.
+        std::size_t GetEnd() const;
+
+        // Drop the tokens already consumed when reading from an input stream.
+        // Their text can't be retrieved with GetText anymore. Streams of
+        // tokens lexed from a whole content are left as they are.
+        void Discard();
+
+    private:
+        // Read and lex the next chunk of the input stream.
+        // Return false if there is nothing left to read.
+        bool Fill();
+        CompactToken GetEndToken() const;
 
     private:
-        TokenType m_Type;
-        TokenValue m_Value;
+        std::string_view m_Content;
+        std::vector<CompactToken> m_Tokens;
+        std::size_t m_Cursor;
+
+        std::istream* m_Stream;
+        std::string m_Buffer;
+        std::size_t m_LexCursor;
+        std::size_t m_TokensCount;
     };
 
-    std::deque<PToken> Lex(const std::string& content);
+    constexpr std::string_view ByteOrderMark = "\xEF\xBB\xBF";
+
+    // Contents of at least two chunks are split between their top-level
+    // entries, to be lexed and parsed on several threads.
+    constexpr std::size_t ParallelChunkSize = 1 << 20;
+
+    // Split the content into chunks of about chunkSize bytes, each ending right
+    // after the closing brace of a top-level block. Braces in strings and comments
+    // are ignored. The spans cover the whole content.
+    std::vector<Span> SplitEntries(std::string_view content, std::size_t chunkSize = ParallelChunkSize);
+
+    // Big contents are lexed by chunks on several threads.
+    std::vector<CompactToken> LexCompact(std::string_view content);
+    // Lex the content from the position start and append the tokens.
+    // If it isn't the last chunk of the input, stop before the last token since
+    // it may continue in the next chunk. Return the position where lexing stopped.
+    std::size_t LexCompact(std::string_view content, std::size_t start, bool last, std::vector<CompactToken>& tokens);
 
-    PToken ReadToken(Reader& reader);
-    PToken ReadString(Reader& reader);
-    PToken ReadNumber(Reader& reader);
-    PToken ReadIdentifier(Reader& reader);
+    bool ReadToken(Reader& reader, CompactToken& token);
+    bool ReadString(Reader& reader, CompactToken& token);
+    // Read a number, a date, a boolean or an identifier in a single pass.
+    bool ReadWord(Reader& reader, CompactToken& token);
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "Parser.hpp"
-#include <filesystem>
+#include "Writer.hpp"
+#include "Diagnostics.hpp"
+#include <bit>
 
 using namespace Parser;
 using namespace Parser::Impl;
@@ -11,41 +13,105 @@ std::string Parser::OperatorToString(Operator op) {
         case Operator::LESS_EQUAL: return "<=";
         case Operator::GREATER: return ">";
         case Operator::GREATER_EQUAL: return ">=";
+        case Operator::NOT_EQUAL: return "!=";
+        case Operator::QUESTION_EQUAL: return "?=";
     }
     return "";
 }
 
+////////////////////////////////
+//        Arena class         //
+////////////////////////////////
+
+static thread_local Arena* s_CurrentArena = nullptr;
+
+Arena::Arena(std::size_t initialSize) :
+    m_Resource(std::max<std::size_t>(initialSize, 1024)),
+    m_References(0)
+{}
+
+std::pmr::memory_resource* Arena::GetResource() {
+    return &m_Resource;
+}
+
+void Arena::Retain() {
+    m_References++;
+}
+
+void Arena::Release() {
+    if(--m_References == 0)
+        delete this;
+}
+
+Arena* Arena::Current() {
+    return s_CurrentArena;
+}
+
+Arena::Scope::Scope(Arena* arena) :
+    m_Arena(arena),
+    m_Previous(s_CurrentArena)
+{
+    // The scope holds a reference so that the arena is freed
+    // if no node has been allocated in it.
+    m_Arena->Retain();
+    s_CurrentArena = m_Arena;
+}
+
+Arena::Scope::~Scope() {
+    s_CurrentArena = m_Previous;
+    m_Arena->Release();
+}
+
 ////////////////////////////////
 //         Node class         //
 ////////////////////////////////
 
 Node::Node() :
-    m_Value(MakeShared<NodeHolder>()),
-    m_Depth(0)
+    m_Holder(nullptr),
+    m_IsNode(true)
 {}
 
 Node::Node(const Node& node) :
-    m_Value((node.m_Value == nullptr) ? nullptr : node.m_Value->Copy()),
-    m_Depth(0)
-{}
+    m_IsNode(node.m_IsNode)
+{
+    if(!m_IsNode)
+        new (&m_Value) RawValue(node.m_Value);
+    else
+        m_Holder = NodeHolder::Share(node.m_Holder);
+}
 
-Node::Node(const RawValue& value) : 
-    m_Value(MakeShared<LeafHolder>(value)),
-    m_Depth(0)
+Node::Node(Node&& node) noexcept :
+    m_IsNode(node.m_IsNode)
+{
+    if(!m_IsNode)
+        new (&m_Value) RawValue(std::move(node.m_Value));
+    else {
+        m_Holder = node.m_Holder;
+        node.m_Holder = nullptr;
+    }
+}
+
+Node::Node(const RawValue& value) :
+    m_Value(value),
+    m_IsNode(false)
 {}
 
-Node::Node(const sf::Color& color) : 
-    m_Value(MakeShared<LeafHolder>(std::vector<double>{(double) color.r, (double) color.g, (double) color.b})), 
-    m_Depth(0)
+Node::Node(const sf::Color& color) :
+    m_Value(std::vector<double>{(double) color.r, (double) color.g, (double) color.b}),
+    m_IsNode(false)
 {}
 
-Node::Node(const std::map<Key, std::pair<Operator, Node>>& values) :
-    m_Value(MakeShared<NodeHolder>(values)),
-    m_Depth(0)
+Node::Node(const Entries& values) :
+    m_Holder(NodeHolder::Create(values)),
+    m_IsNode(true)
 {}
 
+Node::~Node() {
+    this->Reset();
+}
+
 ValueType Node::GetType() const {
-    return m_Value->GetType();
+    return m_IsNode ? ValueType::NODE : (ValueType) m_Value.index();
 }
 
 bool Node::Is(ValueType type) const {
@@ -56,59 +122,161 @@ bool Node::IsList() const {
     ValueType t = this->GetType();
     return (t == ValueType::NUMBER_LIST)
         || (t == ValueType::BOOL_LIST)
-        || (t == ValueType::STRING_LIST);
+        || (t == ValueType::STRING_LIST)
+        || (t == ValueType::RANGE_LIST);
+
+}
+
+// FNV-1a of the strings, since the ids of symbols depend
+// on the order in which they were interned.
+static uint64_t HashString(std::string_view str) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for(unsigned char ch : str) {
+        hash ^= ch;
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+// Mix the value into the hash with the splitmix64 finalizer,
+// so that the order of the values matters.
+static uint64_t CombineHash(uint64_t hash, uint64_t value) {
+    hash ^= value + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111eb;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+static uint64_t HashNumber(double number) {
+    // -0 and 0 are written the same way.
+    if(number == 0)
+        number = 0;
+    return std::bit_cast<uint64_t>(number);
+}
 
+static uint64_t HashDate(const Date& date) {
+    return CombineHash(CombineHash(date.year, date.month), date.day);
 }
 
-uint Node::GetDepth() const {
-    return m_Depth;
+static uint64_t HashScopedString(const ScopedString& str) {
+    return CombineHash(HashString(str.scope), HashString(str.value));
 }
 
-void Node::SetDepth(uint depth) {
-    m_Depth = depth;
-    m_Value->SetDepth(depth);
+static uint64_t HashKey(const Key& key) {
+    uint64_t hash = key.index();
+    switch(key.index()) {
+        case 0: return CombineHash(hash, HashNumber(std::get<double>(key)));
+        case 1: return CombineHash(hash, HashString(std::get<Symbol>(key).Str()));
+        case 2: return CombineHash(hash, HashDate(std::get<Date>(key)));
+        case 3: return CombineHash(hash, HashScopedString(std::get<ScopedString>(key)));
+    }
+    return hash;
+}
+
+static uint64_t HashRaw(const RawValue& value) {
+    uint64_t hash = value.index();
+    switch((ValueType) value.index()) {
+        case ValueType::NUMBER: return CombineHash(hash, HashNumber(std::get<double>(value)));
+        case ValueType::BOOL: return CombineHash(hash, std::get<bool>(value));
+        case ValueType::STRING: return CombineHash(hash, HashString(std::get<Symbol>(value).Str()));
+        case ValueType::DATE: return CombineHash(hash, HashDate(std::get<Date>(value)));
+        case ValueType::SCOPED_STRING: return CombineHash(hash, HashScopedString(std::get<ScopedString>(value)));
+        case ValueType::NUMBER_LIST:
+            for(double number : std::get<std::vector<double>>(value))
+                hash = CombineHash(hash, HashNumber(number));
+            return hash;
+        case ValueType::BOOL_LIST:
+            for(bool b : std::get<std::vector<bool>>(value))
+                hash = CombineHash(hash, b);
+            return hash;
+        case ValueType::STRING_LIST:
+            for(const std::string& str : std::get<std::vector<std::string>>(value))
+                hash = CombineHash(hash, HashString(str));
+            return hash;
+        case ValueType::RANGE_LIST:
+            for(const IntervalList::Interval& interval : std::get<IntervalList>(value).GetIntervals())
+                hash = CombineHash(CombineHash(hash, (uint32_t) interval.first), (uint32_t) interval.last);
+            return hash;
+        default: break;
+    }
+    return hash;
+}
+
+uint64_t Node::GetHash() const {
+    if(!m_IsNode)
+        return HashRaw(m_Value);
+
+    // An empty node has the same hash whether its holder is allocated or not.
+    uint64_t hash = CombineHash(0, (uint64_t) ValueType::NODE);
+    if(m_Holder == nullptr)
+        return hash;
+    if(m_Holder->m_IsHashed && !m_Holder->m_IsExposed)
+        return m_Holder->m_Hash;
+
+    for(const auto& [key, pair] : m_Holder->m_Values) {
+        hash = CombineHash(hash, HashKey(key));
+        hash = CombineHash(hash, (uint64_t) pair.first);
+        hash = CombineHash(hash, pair.second.GetHash());
+    }
+    m_Holder->m_Hash = hash;
+    m_Holder->m_IsHashed = true;
+    return hash;
 }
 
 void Node::Push(const RawValue& value) {
     if(this->GetType() == ValueType::NODE)
         throw std::runtime_error("error: invalid use of 'Node::Push' on non-leaf node.");
     
-    auto holder = this->GetLeafHolder();
+    RawValue& leaf = m_Value;
+
+    // Numbers pushed to a list of ranges, or ranges pushed
+    // to numbers, are merged in a list of ranges.
+    if(this->Is(ValueType::RANGE_LIST) || value.index() == (int) ValueType::RANGE_LIST) {
+        IntervalList list = (IntervalList) *this;
+        list.Add((IntervalList) Node(value));
+        leaf = std::move(list);
+        return;
+    }
 
-    #define CreateList(T) holder->m_Value = std::vector<T>{std::get<T>(holder->m_Value)};
+    // Single strings are stored as symbols whereas lists store
+    // strings, hence the type S of the single value.
+    #define CreateList(T, S) leaf = std::vector<T>{T(std::get<S>(leaf))};
 
     // Check if the value to push into the list
     // is a single value or another list.
-    #define PushToList(T) \
+    #define PushToList(T, S) \
         if(value.index() < 3) { \
-            std::get<std::vector<T>>(holder->m_Value).push_back(std::get<T>(value)); \
+            std::get<std::vector<T>>(leaf).push_back(T(std::get<S>(value))); \
         } \
         else { \
             for(const auto& v : std::get<std::vector<T>>(value)) \
-                std::get<std::vector<T>>(holder->m_Value).push_back(v); \
+                std::get<std::vector<T>>(leaf).push_back(v); \
         } \
 
     switch(this->GetType()) {
         case ValueType::NUMBER:
-            CreateList(double);
-            PushToList(double);
+            CreateList(double, double);
+            PushToList(double, double);
             break;
         case ValueType::BOOL:
-            CreateList(bool);
-            PushToList(bool);
+            CreateList(bool, bool);
+            PushToList(bool, bool);
             break;
         case ValueType::STRING:
-            CreateList(std::string);
-            PushToList(std::string);
+            CreateList(std::string, Symbol);
+            PushToList(std::string, Symbol);
             break;
         case ValueType::NUMBER_LIST:
-            PushToList(double);
+            PushToList(double, double);
             break;
         case ValueType::BOOL_LIST:
-            PushToList(bool);
+            PushToList(bool, bool);
             break;
         case ValueType::STRING_LIST:
-            PushToList(std::string);
+            PushToList(std::string, Symbol);
             break;
         default:
             break;
@@ -118,21 +286,31 @@ void Node::Push(const RawValue& value) {
 Node& Node::Get(const Key& key) {
     if(!this->Is(ValueType::NODE))
         throw std::runtime_error("error: invalid use of 'Node::Get' on leaf node.");
-    return this->GetNodeHolder()->m_Values[key].second;
+    return this->ExposeNodeHolder().m_Values[key].second;
 }
 
 const Node& Node::Get(const Key& key) const {
     if(!this->Is(ValueType::NODE))
         throw std::runtime_error("error: invalid use of 'Node::Get' on leaf node.");
-    return this->GetNodeHolder()->m_Values[key].second;
+
+    // Unlike the non-const version, a missing key isn't inserted.
+    static const Node empty;
+    const NodeHolder* holder = this->GetNodeHolder();
+    if(holder == nullptr)
+        return empty;
+    auto it = holder->m_Values.find(key);
+    return (it == holder->m_Values.end()) ? empty : it->second.second;
 }
 
 template <typename T>
 T Node::Get(const Key& key, T defaultValue) const {
     if(!this->Is(ValueType::NODE))
         throw std::runtime_error("error: invalid use of 'Node::Get' on leaf node.");
-    auto it = this->GetNodeHolder()->m_Values.find(key);
-    if(it == this->GetNodeHolder()->m_Values.end())
+    const NodeHolder* holder = this->GetNodeHolder();
+    if(holder == nullptr)
+        return defaultValue;
+    auto it = holder->m_Values.find(key);
+    if(it == holder->m_Values.end())
         return defaultValue;
     return it->second.second;
 }
@@ -141,11 +319,13 @@ template int Node::Get<int>(const Key&, int) const;
 template double Node::Get<double>(const Key&, double) const;
 template bool Node::Get<bool>(const Key&, bool) const;
 template std::string Node::Get<std::string>(const Key&, std::string) const;
+template Symbol Node::Get<Symbol>(const Key&, Symbol) const;
 template Date Node::Get<Date>(const Key&, Date) const;
 template ScopedString Node::Get<ScopedString>(const Key&, ScopedString) const;
 template std::vector<double> Node::Get<std::vector<double>>(const Key&, std::vector<double>) const;
 template std::vector<bool> Node::Get<std::vector<bool>>(const Key&, std::vector<bool>) const;
 template std::vector<std::string> Node::Get<std::vector<std::string>>(const Key&, std::vector<std::string>) const;
+template IntervalList Node::Get<IntervalList>(const Key&, IntervalList) const;
 template RawValue Node::Get<RawValue>(const Key&, RawValue) const;
 template Key Node::Get<Key>(const Key&, Key) const;
 template sf::Color Node::Get<sf::Color>(const Key&, sf::Color) const;
@@ -153,19 +333,21 @@ template sf::Color Node::Get<sf::Color>(const Key&, sf::Color) const;
 Operator Node::GetOperator(const Key& key) {
     if(!this->Is(ValueType::NODE))
         throw std::runtime_error("error: invalid use of 'Node::GetOperator' on leaf node.");
-    return this->GetNodeHolder()->m_Values[key].first;
+    return this->GetNodeHolder().m_Values[key].first;
 }
 
-std::map<Key, std::pair<Operator, Node>>& Node::GetEntries() {
+Entries& Node::GetEntries() {
     if(!this->Is(ValueType::NODE))
         throw std::runtime_error("error: invalid use of 'Node::GetEntries' on leaf node.");
-    return this->GetNodeHolder()->m_Values;
+    return this->ExposeNodeHolder().m_Values;
 }
 
-const std::map<Key, std::pair<Operator, Node>>& Node::GetEntries() const {
+const Entries& Node::GetEntries() const {
     if(!this->Is(ValueType::NODE))
         throw std::runtime_error("error: invalid use of 'Node::GetEntries' on leaf node.");
-    return this->GetNodeHolder()->m_Values;
+    static const Entries empty;
+    const NodeHolder* holder = this->GetNodeHolder();
+    return (holder == nullptr) ? empty : holder->m_Values;
 }
 
 std::vector<Key> Node::GetKeys() const {
@@ -173,8 +355,7 @@ std::vector<Key> Node::GetKeys() const {
         throw std::runtime_error("error: invalid use of 'Node::GetKeys' on leaf node.");
     
     std::vector<Key> keys;
-    auto holder = this->GetNodeHolder();
-    for(const auto& [key, pair] : holder->m_Values)
+    for(const auto& [key, pair] : this->GetEntries())
         keys.push_back(key);
 
     return keys;
@@ -183,98 +364,180 @@ std::vector<Key> Node::GetKeys() const {
 bool Node::ContainsKey(const Key& key) const{
     if(!this->Is(ValueType::NODE))
         throw std::runtime_error("error: invalid use of 'Node::ContainsKey' on leaf node.");
-    return this->GetNodeHolder()->m_Values.count(key) > 0;
+    const NodeHolder* holder = this->GetNodeHolder();
+    return holder != nullptr && holder->m_Values.count(key) > 0;
 }
 
 void Node::Put(const Key& key, const Node& node, Operator op) {
+    // Share the node before modifying our own entries,
+    // in case it is this node or one of its parents.
+    this->Put(key, Node(node), op);
+}
+
+void Node::Put(const Key& key, Node&& node, Operator op) {
     if(!this->Is(ValueType::NODE))
         throw std::runtime_error("error: invalid use of 'Node::Put' on leaf node.");
-    this->GetNodeHolder()->m_Values[key] = std::make_pair(op, node);
-    this->GetNodeHolder()->m_Values[key].second.SetDepth(m_Depth + 1);
+    auto& pair = this->GetNodeHolder().m_Values[key];
+    pair.first = op;
+    pair.second = std::move(node);
 }
 
 void Node::Put(const Key& key, const RawValue& value, Operator op) {
     this->Put(key, Node(value), op);
 }
 
+// Values of those types are pushed into lists of the same base type.
+static int GetMergedType(ValueType type) {
+    switch(type) {
+        case ValueType::NUMBER:
+        case ValueType::NUMBER_LIST:
+        case ValueType::RANGE_LIST:
+            return (int) ValueType::NUMBER;
+        case ValueType::BOOL:
+        case ValueType::BOOL_LIST:
+            return (int) ValueType::BOOL;
+        case ValueType::STRING:
+        case ValueType::STRING_LIST:
+            return (int) ValueType::STRING;
+        default:
+            return (int) type;
+    }
+}
+
+bool Node::Append(const Key& key, const Node& node, Operator op) {
+    if(!this->ContainsKey(key)) {
+        this->Put(key, node, op);
+        return true;
+    }
+
+    // The entry is reached through the holder so that it isn't exposed.
+    Node& current = this->GetNodeHolder().m_Values[key].second;
+
+    if(GetMergedType(current.GetType()) != GetMergedType(node.GetType()))
+        return false;
+
+    // Dates, scoped strings and blocks aren't merged, the first one is kept.
+    if(!current.Is(ValueType::NODE)) {
+        current.Push((RawValue) node);
+    }
+
+    // TODO: handle array of nodes?
+    return true;
+}
+
+bool Node::Append(const Key& key, Node&& node, Operator op) {
+    if(!this->ContainsKey(key)) {
+        this->Put(key, std::move(node), op);
+        return true;
+    }
+    return this->Append(key, (const Node&) node, op);
+}
+
 Node Node::Remove(const Key& key) {
     if(!this->Is(ValueType::NODE))
         throw std::runtime_error("error: invalid use of 'Node::Remove' on leaf node.");
-    Node value = std::move(this->GetNodeHolder()->m_Values[key].second);
-    this->GetNodeHolder()->m_Values.erase(key);
+    Entries& values = this->GetNodeHolder().m_Values;
+    auto it = values.find(key);
+    if(it == values.end())
+        return Node();
+    Node value = std::move(it->second.second);
+    values.erase(it);
     return value;
 }
 
 Node::operator int() const {
     if(!this->Is(ValueType::NUMBER))
         throw std::runtime_error("error: invalid cast from 'node' to type 'int'");
-    return (int) std::get<double>(this->GetLeafHolder()->m_Value);
+    return (int) std::get<double>(m_Value);
 }
 
 Node::operator double() const {
     if(!this->Is(ValueType::NUMBER))
         throw std::runtime_error("error: invalid cast from 'node' to type 'double'");
-    return std::get<double>(this->GetLeafHolder()->m_Value);
+    return std::get<double>(m_Value);
 }
 
 Node::operator bool() const {
     if(!this->Is(ValueType::BOOL))
         throw std::runtime_error("error: invalid cast from 'node' to type 'bool'");
-    return std::get<bool>(this->GetLeafHolder()->m_Value);
+    return std::get<bool>(m_Value);
 }
 
 Node::operator std::string() const {
     if(!this->Is(ValueType::STRING))
         throw std::runtime_error("error: invalid cast from 'node' to type 'std::string'");
-    return std::get<std::string>(this->GetLeafHolder()->m_Value);
+    return std::get<Symbol>(m_Value).Str();
+}
+
+Node::operator Symbol() const {
+    if(!this->Is(ValueType::STRING))
+        throw std::runtime_error("error: invalid cast from 'node' to type 'Symbol'");
+    return std::get<Symbol>(m_Value);
 }
 
 Node::operator Date() const {
     if(!this->Is(ValueType::DATE))
         throw std::runtime_error("error: invalid cast from 'node' to type 'Date'");
-    return std::get<Date>(this->GetLeafHolder()->m_Value);
+    return std::get<Date>(m_Value);
 }
 
 Node::operator ScopedString() const {
     if(!this->Is(ValueType::SCOPED_STRING))
         throw std::runtime_error("error: invalid cast from 'node' to type 'ScopedString'");
-    return std::get<ScopedString>(this->GetLeafHolder()->m_Value);
+    return std::get<ScopedString>(m_Value);
 }
 
 Node::operator std::vector<double>&() const {
     if(!this->Is(ValueType::NUMBER_LIST))
         throw std::runtime_error("error: invalid cast from 'node' to type 'std::vector<double>&'");
-    return std::get<std::vector<double>>(this->GetLeafHolder()->m_Value);
+    return std::get<std::vector<double>>(this->GetLeaf());
 }
 
 Node::operator std::vector<bool>&() const {
     if(!this->Is(ValueType::BOOL_LIST))
         throw std::runtime_error("error: invalid cast from 'node' to type 'std::vector<bool>&'");
-    return std::get<std::vector<bool>>(this->GetLeafHolder()->m_Value);
+    return std::get<std::vector<bool>>(this->GetLeaf());
 }
 
 Node::operator std::vector<std::string>&() const {
     if(!this->Is(ValueType::STRING_LIST))
         throw std::runtime_error("error: invalid cast from 'node' to type 'std::vector<std::string>&'");
-    return std::get<std::vector<std::string>>(this->GetLeafHolder()->m_Value);
+    return std::get<std::vector<std::string>>(this->GetLeaf());
+}
+
+Node::operator IntervalList() const {
+    switch(this->GetType()) {
+        case ValueType::NUMBER:
+            return IntervalList((int32_t) std::get<double>(m_Value), (int32_t) std::get<double>(m_Value));
+        case ValueType::NUMBER_LIST: {
+            IntervalList list;
+            for(double value : std::get<std::vector<double>>(m_Value))
+                list.Add((int32_t) value);
+            return list;
+        }
+        case ValueType::RANGE_LIST:
+            return std::get<IntervalList>(m_Value);
+        default:
+            throw std::runtime_error("error: invalid cast from 'node' to type 'IntervalList'");
+    }
 }
 
 Node::operator RawValue&() const {
     if(this->Is(ValueType::NODE))
         throw std::runtime_error("error: invalid cast from 'node' to type 'RawValue&'");
-    return this->GetLeafHolder()->m_Value;
+    return this->GetLeaf();
 }
 
 Node::operator Key() const {
     switch(this->GetType()) {
         case ValueType::NUMBER:
-            return std::get<double>(this->GetLeafHolder()->m_Value);
+            return std::get<double>(m_Value);
         case ValueType::STRING:
-            return std::get<std::string>(this->GetLeafHolder()->m_Value);
+            return std::get<Symbol>(m_Value);
         case ValueType::DATE:
-            return std::get<Date>(this->GetLeafHolder()->m_Value);
+            return std::get<Date>(m_Value);
         case ValueType::SCOPED_STRING:
-            return std::get<ScopedString>(this->GetLeafHolder()->m_Value);
+            return std::get<ScopedString>(m_Value);
         default:
             throw std::runtime_error("error: invalid cast from 'node' to type 'Key'");
     }
@@ -284,7 +547,7 @@ Node::operator sf::Color() const {
     if(!this->Is(ValueType::NUMBER_LIST))
         throw std::runtime_error("error: invalid cast from 'node' to type 'sf::Color&'");
     
-    std::vector<double> values = std::get<std::vector<double>>(this->GetLeafHolder()->m_Value);
+    const std::vector<double>& values = std::get<std::vector<double>>(m_Value);
     
     if(values.size() < 3)
         throw std::runtime_error("error: invalid cast from 'node' to type 'sf::Color&'");
@@ -293,20 +556,50 @@ Node::operator sf::Color() const {
 }
 
 Node& Node::operator=(const RawValue& value) {
-    if(this->GetType() == ValueType::NODE)
-        m_Value = MakeShared<LeafHolder>(value);
+    if(m_IsNode) {
+        this->Reset();
+        new (&m_Value) RawValue(value);
+        m_IsNode = false;
+    }
     else
-        this->GetLeafHolder()->m_Value = value;
+        m_Value = value;
     return *this;
 }
 
 Node& Node::operator=(const Node& value) {
-    if(!this->Is(ValueType::NODE) && !value.Is(ValueType::NODE))
-        this->GetLeafHolder()->m_Value = value.GetLeafHolder()->m_Value;
+    if(this == &value)
+        return *this;
+    if(!m_IsNode && !value.m_IsNode)
+        m_Value = value.m_Value;
+    else {
+        // Share first in case the value is one of our own children.
+        NodeHolder* holder = value.m_IsNode ? NodeHolder::Share(value.m_Holder) : nullptr;
+        this->Reset();
+        m_IsNode = value.m_IsNode;
+        if(m_IsNode)
+            m_Holder = holder;
+        else
+            new (&m_Value) RawValue(value.m_Value);
+    }
+    return *this;
+}
+
+Node& Node::operator=(Node&& value) noexcept {
+    if(this == &value)
+        return *this;
+    if(!m_IsNode && !value.m_IsNode)
+        m_Value = std::move(value.m_Value);
     else {
-        auto holder = value.m_Value->Copy();
-        holder->SetDepth(m_Depth);
-        m_Value = value.m_Value->Copy();
+        // Keep the value alive in case it is one of our own children.
+        Node tmp(std::move(value));
+        this->Reset();
+        m_IsNode = tmp.m_IsNode;
+        if(m_IsNode) {
+            m_Holder = tmp.m_Holder;
+            tmp.m_Holder = nullptr;
+        }
+        else
+            new (&m_Value) RawValue(std::move(tmp.m_Value));
     }
     return *this;
 }
@@ -323,446 +616,722 @@ const Node& Node::operator [](const Key& key) const {
     return this->Get(key);
 }
 
-SharedPtr<LeafHolder> Node::GetLeafHolder() {
-    return std::dynamic_pointer_cast<LeafHolder>(m_Value);
+NodeHolder& Node::GetNodeHolder() {
+    if(m_Holder == nullptr) {
+        m_Holder = NodeHolder::Create();
+    }
+    else if(m_Holder->m_References > 1) {
+        // Only the entries are copied, their own blocks are still shared.
+        NodeHolder* holder = NodeHolder::Create(m_Holder->m_Values);
+        NodeHolder::Release(m_Holder);
+        m_Holder = holder;
+    }
+    // The caller may modify the entries, which are hashed again when needed.
+    m_Holder->m_IsHashed = false;
+    return *m_Holder;
+}
+
+NodeHolder& Node::ExposeNodeHolder() {
+    NodeHolder& holder = this->GetNodeHolder();
+    holder.m_IsExposed = true;
+    return holder;
 }
 
-const SharedPtr<LeafHolder> Node::GetLeafHolder() const {
-    return std::dynamic_pointer_cast<LeafHolder>(m_Value);
+const NodeHolder* Node::GetNodeHolder() const {
+    return m_Holder;
 }
 
-SharedPtr<NodeHolder> Node::GetNodeHolder() {
-    return std::dynamic_pointer_cast<NodeHolder>(m_Value);
+RawValue& Node::GetLeaf() const {
+    // Leaf values can be modified through the casts to references,
+    // the same way they were with the shared value holders. Those of
+    // a shared block must be reached through the non-const functions
+    // first so that the block is copied.
+    return const_cast<RawValue&>(m_Value);
 }
 
-const SharedPtr<NodeHolder> Node::GetNodeHolder() const {
-    return std::dynamic_pointer_cast<NodeHolder>(m_Value);
+void Node::Reset() {
+    if(!m_IsNode)
+        m_Value.~RawValue();
+    else if(m_Holder != nullptr)
+        NodeHolder::Release(m_Holder);
+    m_Holder = nullptr;
+    m_IsNode = true;
 }
 
 ////////////////////////////////
-//      NodeHolder class      //
+//       Entries class        //
 ////////////////////////////////
 
+Entries::Entries(allocator_type allocator) :
+    m_Entries(allocator),
+    m_Index(allocator)
+{}
+
+Entries::Entries(const Entries& entries, allocator_type allocator) :
+    m_Entries(entries.m_Entries, allocator),
+    m_Index(allocator)
+{
+    if(m_Entries.size() > IndexThreshold)
+        this->BuildIndex();
+}
+
+Entries& Entries::operator=(const Entries& entries) {
+    if(this == &entries)
+        return *this;
+    m_Entries = entries.m_Entries;
+    m_Index.clear();
+    if(m_Entries.size() > IndexThreshold)
+        this->BuildIndex();
+    return *this;
+}
 
-NodeHolder::NodeHolder() {
+Entries::iterator Entries::begin() {
+    return m_Entries.begin();
+}
 
+Entries::iterator Entries::end() {
+    return m_Entries.end();
 }
 
-NodeHolder::NodeHolder(const NodeHolder& n) {
-    for(auto [key, pair] : n.m_Values) {
-        m_Values[key] = *(&pair);
-    }
+Entries::const_iterator Entries::begin() const {
+    return m_Entries.begin();
+}
+
+Entries::const_iterator Entries::end() const {
+    return m_Entries.end();
+}
+
+std::size_t Entries::size() const {
+    return m_Entries.size();
 }
 
-NodeHolder::NodeHolder(const std::map<Key, std::pair<Operator, Node>>& values) {
-    m_Values = values;
+bool Entries::empty() const {
+    return m_Entries.empty();
 }
 
-ValueType NodeHolder::GetType() const {
-    return ValueType::NODE;
+Entries::iterator Entries::find(const Key& key) {
+    return m_Entries.begin() + this->IndexOf(key);
 }
 
-SharedPtr<AbstractValueHolder> NodeHolder::Copy() const {
-    SharedPtr<NodeHolder> copy = MakeShared<NodeHolder>();
-    for(const auto&[key, pair] : m_Values) {
-        copy->m_Values[key] = *(&pair);
+Entries::const_iterator Entries::find(const Key& key) const {
+    return m_Entries.begin() + this->IndexOf(key);
+}
+
+std::size_t Entries::count(const Key& key) const {
+    return this->IndexOf(key) < m_Entries.size() ? 1 : 0;
+}
+
+std::pair<Operator, Node>& Entries::operator[](const Key& key) {
+    std::size_t index = this->IndexOf(key);
+    if(index < m_Entries.size())
+        return m_Entries[index].second;
+
+    m_Entries.emplace_back(key, std::make_pair(Operator::EQUAL, Node()));
+
+    if(!m_Index.empty())
+        m_Index.emplace(key, (uint32_t) index);
+    else if(m_Entries.size() > IndexThreshold)
+        this->BuildIndex();
+
+    return m_Entries.back().second;
+}
+
+Entries::iterator Entries::erase(iterator it) {
+    std::size_t index = it - m_Entries.begin();
+
+    // Only the indices of the following entries change, they are shifted
+    // by one. The index is kept even if there are few entries left.
+    if(!m_Index.empty()) {
+        m_Index.erase(it->first);
+        for(auto next = it + 1; next != m_Entries.end(); next++)
+            m_Index[next->first]--;
     }
-    return copy;
+    m_Entries.erase(it);
+
+    return m_Entries.begin() + index;
 }
 
-void NodeHolder::SetDepth(uint depth) {
-    for(auto& [key, pair] : m_Values)
-        pair.second.SetDepth(depth + 1);
+std::size_t Entries::IndexOf(const Key& key) const {
+    if(!m_Index.empty()) {
+        auto it = m_Index.find(key);
+        return (it == m_Index.end()) ? m_Entries.size() : it->second;
+    }
+    for(std::size_t i = 0; i < m_Entries.size(); i++) {
+        if(m_Entries[i].first == key)
+            return i;
+    }
+    return m_Entries.size();
+}
+
+void Entries::BuildIndex() {
+    m_Index.reserve(m_Entries.size());
+    for(std::size_t i = 0; i < m_Entries.size(); i++)
+        m_Index.emplace(m_Entries[i].first, (uint32_t) i);
 }
 
 ////////////////////////////////
-//      LeafHolder class      //
+//      NodeHolder class      //
 ////////////////////////////////
 
-LeafHolder::LeafHolder() : m_Value(0.0) {}
+NodeHolder::NodeHolder(Arena* arena) :
+    m_Arena(arena),
+    m_Values(arena ? arena->GetResource() : std::pmr::get_default_resource()),
+    m_References(1),
+    m_Hash(0),
+    m_IsHashed(false),
+    m_IsExposed(false)
+{}
 
-LeafHolder::LeafHolder(const LeafHolder& l) : m_Value(l.m_Value) {}
+NodeHolder::NodeHolder(Arena* arena, const Entries& values) :
+    m_Arena(arena),
+    m_Values(values, arena ? arena->GetResource() : std::pmr::get_default_resource()),
+    m_References(1),
+    m_Hash(0),
+    m_IsHashed(false),
+    m_IsExposed(false)
+{}
 
-LeafHolder::LeafHolder(const RawValue& value) : m_Value(value) {}
+NodeHolder* NodeHolder::Create() {
+    Arena* arena = Arena::Current();
+    if(arena == nullptr)
+        return new NodeHolder(nullptr);
 
-ValueType LeafHolder::GetType() const {
-    return (ValueType) m_Value.index();
+    void* memory = arena->GetResource()->allocate(sizeof(NodeHolder), alignof(NodeHolder));
+    arena->Retain();
+    return new (memory) NodeHolder(arena);
 }
 
-SharedPtr<AbstractValueHolder> LeafHolder::Copy() const {
-    SharedPtr<LeafHolder> copy = MakeShared<LeafHolder>();
-    copy->m_Value = m_Value;
-    return copy;
+NodeHolder* NodeHolder::Create(const Entries& values) {
+    Arena* arena = Arena::Current();
+    if(arena == nullptr)
+        return new NodeHolder(nullptr, values);
+
+    void* memory = arena->GetResource()->allocate(sizeof(NodeHolder), alignof(NodeHolder));
+    arena->Retain();
+    return new (memory) NodeHolder(arena, values);
+}
+
+NodeHolder* NodeHolder::Share(NodeHolder* holder) {
+    if(holder == nullptr)
+        return nullptr;
+
+    // The entries of an exposed holder may still be modified through the
+    // references returned, so the copy gets its own entries right away.
+    // Nested blocks which weren't exposed are still shared.
+    if(holder->m_IsExposed)
+        return NodeHolder::Create(holder->m_Values);
+
+    holder->m_References++;
+    return holder;
 }
 
-void LeafHolder::SetDepth(uint depth) {}
+void NodeHolder::Release(NodeHolder* holder) {
+    if(--holder->m_References > 0)
+        return;
+
+    Arena* arena = holder->m_Arena;
+    if(arena == nullptr) {
+        delete holder;
+        return;
+    }
+
+    // The memory itself is only given back when the whole arena is freed.
+    holder->~NodeHolder();
+    arena->Release();
+}
 
 Node Parser::Parse(const std::string& filePath) {
-    std::ifstream file(filePath);
-    std::string content = File::ReadString(file);
-    file.close();
+    // The file is mapped instead of being copied and the nodes
+    // copy the values they need, so it can be unmapped right after.
+    File::MappedFile file(filePath);
 
-    std::deque<PToken> tokens = Parser::Lex(content);
-    Node node = Parse(tokens);
-    node.SetDepth(0);
-    return node;
+    // Each chunk of a big file has its own arena.
+    if(file.GetSize() >= 2 * ParallelChunkSize)
+        return ParseParallel(file.GetContent());
+
+    // All the holders of the file are allocated in the same arena.
+    Arena::Scope scope(new Arena(file.GetSize()));
+
+    TokenStream tokens(file.GetContent());
+    return Parse(tokens);
 }
 
-Node Parser::Parse(std::deque<PToken>& tokens, uint depth) {
-    enum ParsingState { KEY, OPERATOR, VALUE };
-    ParsingState state = KEY;
+////////////////////////////////
+//     EntryStream class      //
+////////////////////////////////
 
+EntryStream::EntryStream(const std::string& filePath) :
+    m_File(filePath, std::ios::binary),
+    m_Tokens(m_File)
+{}
+
+bool EntryStream::Next(Key& key, Operator& op, Node& value) {
+    // Each entry gets its own arena, so that it is freed
+    // as soon as the caller doesn't need it anymore.
+    Arena::Scope scope(new Arena());
+
+    // The previous entry has been parsed, its tokens aren't needed anymore.
+    m_Tokens.Discard();
+    return ParseEntry(m_Tokens, key, op, value, false);
+}
+
+// Parse the entries of the content, or those of a block after its opening brace.
+static Node ParseEntries(TokenStream& tokens, bool inBlock) {
     Node values;
     Key key;
     Operator op = Operator::EQUAL;
+    Node node;
 
-    while(!tokens.empty()) {
-        PToken token = tokens.front();
-        tokens.pop_front();
+    for(std::size_t start = tokens.GetOffset(); ParseEntry(tokens, key, op, node, inBlock); start = tokens.GetOffset())
+        AppendEntry(values, key, std::move(node), op, tokens.GetContent(), start);
 
-        if(token->Is(TokenType::RIGHT_BRACE))
-            break;
-            
-        if(token->Is(TokenType::COMMENT))
+    return values;
+}
+
+Node Parser::Parse(TokenStream& tokens) {
+    return ParseEntries(tokens, false);
+}
+
+Node Parser::ParseParallel(std::string_view content) {
+    std::vector<Span> chunks = SplitEntries(content);
+    std::vector<std::vector<std::tuple<Key, Operator, Node, std::size_t>>> chunksEntries(chunks.size());
+    const Diagnostics::Scope* diagnostics = Diagnostics::Scope::Current();
+
+    Parallel::For(chunks.size(), [&](std::size_t i) {
+        // The holders of each chunk are allocated in their own arena,
+        // since arenas can't be shared between threads.
+        Arena::Scope scope(new Arena(chunks[i].length));
+        Diagnostics::Scope diagnosticsScope(diagnostics);
+
+        // The chunk is lexed from its offset in the whole content.
+        std::string_view chunk = content.substr(0, chunks[i].End());
+        std::vector<CompactToken> tokens;
+        LexCompact(chunk, chunks[i].offset, true, tokens);
+        TokenStream stream(chunk, std::move(tokens));
+
+        Key key;
+        Operator op = Operator::EQUAL;
+        Node value;
+        for(std::size_t start = stream.GetOffset(); ParseEntry(stream, key, op, value, false); start = stream.GetOffset())
+            chunksEntries[i].emplace_back(key, op, std::move(value), start);
+    });
+
+    // The entries are appended in the order of the content so that
+    // duplicated keys are merged the same way as Parse does.
+    Node values;
+    for(auto& entries : chunksEntries) {
+        for(auto& [key, op, value, start] : entries)
+            AppendEntry(values, key, std::move(value), op, content, start);
+    }
+    return values;
+}
+
+void Visitor::OnDecode(const Key& key, Operator op, TokenStream& tokens) {
+    SkipNode(tokens);
+}
+
+void Parser::Visit(const std::string& filePath, Visitor& visitor) {
+    File::MappedFile file(filePath);
+    Arena::Scope scope(new Arena());
+
+    TokenStream tokens(file.GetContent());
+    Visit(tokens, visitor);
+}
+
+// Visit the entries of the content, or those of a block after its opening brace.
+static void VisitEntries(TokenStream& tokens, Visitor& visitor, bool inBlock) {
+    Key key;
+    Operator op = Operator::EQUAL;
+
+    std::size_t start = tokens.GetOffset();
+
+    for(; ParseKey(tokens, key, op, inBlock); start = tokens.GetOffset()) {
+        switch(visitor.OnKey(key, op, start)) {
+            case Visitor::Action::DESCEND: {
+                // Lists are values even though they start with a brace.
+                if(tokens.Peek().Is(TokenType::LEFT_BRACE)) {
+                    tokens.Next();
+                    if(!IsList(tokens)) {
+                        visitor.OnBeginBlock(key, op);
+                        VisitEntries(tokens, visitor, true);
+                        Span span{(uint32_t) start, (uint32_t) (tokens.GetEnd() - start)};
+                        visitor.OnEndBlock(key, span);
+                        break;
+                    }
+                    Node value = ParseBlock(tokens);
+                    Span span{(uint32_t) start, (uint32_t) (tokens.GetEnd() - start)};
+                    visitor.OnValue(key, op, value, span);
+                    break;
+                }
+                Node value = ParseNode(tokens);
+                Span span{(uint32_t) start, (uint32_t) (tokens.GetEnd() - start)};
+                visitor.OnValue(key, op, value, span);
+                break;
+            }
+            case Visitor::Action::MATERIALIZE: {
+                Node value = ParseNode(tokens);
+                Span span{(uint32_t) start, (uint32_t) (tokens.GetEnd() - start)};
+                visitor.OnValue(key, op, value, span);
+                break;
+            }
+            case Visitor::Action::SKIP:
+                SkipNode(tokens);
+                break;
+            case Visitor::Action::DECODE:
+                visitor.OnDecode(key, op, tokens);
+                break;
+        }
+    }
+}
+
+void Parser::Visit(TokenStream& tokens, Visitor& visitor) {
+    VisitEntries(tokens, visitor, false);
+}
+
+// Report an error at the offset, which is thrown if there isn't any diagnostics sink.
+static void ReportError(TokenStream& tokens, std::size_t offset, std::string_view message) {
+    Diagnostics::Report(tokens.GetContent(), offset, Diagnostic::Severity::ERROR, message);
+}
+
+static void ReportWarning(TokenStream& tokens, std::size_t offset, std::string_view message) {
+    Diagnostics::Report(tokens.GetContent(), offset, Diagnostic::Severity::WARNING, message);
+}
+
+// Report the token, which has already been read, and skip
+// the whole block if it opens one to stay at the same depth.
+static void SkipUnexpected(TokenStream& tokens, const CompactToken& token, std::string_view message) {
+    ReportError(tokens, token.offset, message);
+    if(!token.Is(TokenType::LEFT_BRACE))
+        return;
+
+    int depth = 1;
+    while(depth > 0 && !tokens.Empty()) {
+        CompactToken next = tokens.Next();
+        if(next.Is(TokenType::LEFT_BRACE))
+            depth++;
+        else if(next.Is(TokenType::RIGHT_BRACE))
+            depth--;
+    }
+}
+
+bool Parser::Impl::ParseEntry(TokenStream& tokens, Key& key, Operator& op, Node& value, bool inBlock) {
+    if(!ParseKey(tokens, key, op, inBlock))
+        return false;
+    value = ParseNode(tokens);
+    return true;
+}
+
+void Parser::Impl::AppendEntry(Node& values, const Key& key, Node&& value, Operator op, std::string_view content, std::size_t offset) {
+    if(!values.Append(key, std::move(value), op))
+        Diagnostics::Report(content, offset, Diagnostic::Severity::ERROR, fmt::format("duplicated key with another type of value, the first one is kept: {}", key));
+}
+
+bool Parser::Impl::ParseKey(TokenStream& tokens, Key& key, Operator& op, bool inBlock) {
+    enum ParsingState { KEY, OPERATOR, VALUE };
+    ParsingState state = KEY;
+
+    while(!tokens.Empty()) {
+        CompactToken token = tokens.Peek();
+
+        // The rest of the content is still parsed after a stray closing brace.
+        if(token.Is(TokenType::RIGHT_BRACE) && !inBlock) {
+            tokens.Next();
+            ReportError(tokens, token.offset, "unexpected closing brace outside of any block");
             continue;
+        }
+
+        if(token.Is(TokenType::RIGHT_BRACE)) {
+            if(state != KEY)
+                ReportWarning(tokens, token.offset, "missing value before the end of the block");
+            tokens.Next();
+            return false;
+        }
 
         switch(state) {
             case KEY:
-                if(token->Is(TokenType::IDENTIFIER)) {
+                tokens.Next();
+
+                if(token.Is(TokenType::IDENTIFIER)) {
                     key = ParseIdentifier(token, tokens);
                     state = ParsingState::OPERATOR;
                     break;
                 }
                 
-                if(token->Is(TokenType::NUMBER)) {
-                    key = std::get<double>(token->GetValue());
+                if(token.Is(TokenType::NUMBER)) {
+                    key = token.number;
                     state = ParsingState::OPERATOR;
                     break;
                 }
                 
-                if(token->Is(TokenType::DATE)) {
-                    key = std::get<Date>(token->GetValue());
+                if(token.Is(TokenType::DATE)) {
+                    key = token.GetDate();
                     state = ParsingState::OPERATOR;
                     break;
                 }
 
-                throw std::runtime_error(fmt::format("Unexpected token while parsing key ({}).", (int) token->GetType()));
+                SkipUnexpected(tokens, token, "unexpected token while parsing key");
                 break;
 
             case OPERATOR:
-                if(token->Is(TokenType::EQUAL)
-                    || token->Is(TokenType::GREATER)
-                    || token->Is(TokenType::GREATER_EQUAL)
-                    || token->Is(TokenType::LESS)
-                    || token->Is(TokenType::LESS_EQUAL)
+                if(token.Is(TokenType::EQUAL)
+                    || token.Is(TokenType::GREATER)
+                    || token.Is(TokenType::GREATER_EQUAL)
+                    || token.Is(TokenType::LESS)
+                    || token.Is(TokenType::LESS_EQUAL)
+                    || token.Is(TokenType::NOT_EQUAL)
+                    || token.Is(TokenType::QUESTION_EQUAL)
                 ) {
+                    tokens.Next();
                     state = ParsingState::VALUE;
-                    op = (Operator)(((int) token->GetType()) - 3);
+                    op = (Operator)(((int) token.type) - 3);
                     break;
                 }
-                throw std::runtime_error(fmt::format("Unexpected token while operator ({}).", (int) token->GetType()));
-                break;
-                
-            case VALUE:
-                tokens.push_front(token);
-                Node node = ParseNode(tokens);
 
-                if(values.ContainsKey(key)) {
-                    Node& current = values[key];
-
-                    if(!current.Is(ValueType::NODE)) {
-                        current.Push((RawValue) node);
-                    }
-
-                    // TODO: handle array of nodes?
-                }
-                else {
-                    values.Put(key, std::move(node), op);
+                // A block right after the key is read as its value,
+                // otherwise the token is read again as the next key.
+                ReportError(tokens, token.offset, "missing operator after key");
+                if(token.Is(TokenType::LEFT_BRACE)) {
+                    state = ParsingState::VALUE;
+                    op = Operator::EQUAL;
+                    break;
                 }
                 state = ParsingState::KEY;
                 break;
+                
+            case VALUE:
+                return true;
         }
     }
 
-    values.SetDepth(depth);
-    return values;
+    if(state != KEY)
+        ReportWarning(tokens, tokens.GetEnd(), "missing value at the end of the content");
+    if(inBlock)
+        ReportError(tokens, tokens.GetEnd(), "missing closing brace at the end of the block");
+    return false;
 }
 
-Node Parser::Impl::ParseNode(std::deque<PToken>& tokens) {
-    PToken token = tokens.front();
-    tokens.pop_front();
+Node Parser::Impl::ParseNode(TokenStream& tokens) {
+    CompactToken token = tokens.Next();
 
-    // Handle RANGE keyword by generating a list of all the numbers between A and B
-    // as in: RANGE { A  B }
-    if(token->Is(TokenType::IDENTIFIER) && std::get<std::string>(token->GetValue()) == "RANGE") {
-        if(tokens.empty())
-            throw std::runtime_error("error: unexpected end while parsing range.");
+    // Handle colors with a prefix as in: hsv { 0.5 0.8 0.6 }
+    if(token.Is(TokenType::COLOR)) {
+        if(tokens.Empty() || !tokens.Peek().Is(TokenType::LEFT_BRACE)) {
+            ReportError(tokens, token.offset, "missing block after color prefix");
+            return Node();
+        }
+        tokens.Next();
 
-        // Remove LEFT_BRACE token from the list.
-        token = tokens.front();
-        tokens.pop_front();
+        std::vector<double> values = ParseList<double>(tokens);
+        if(values.size() < 3) {
+            ReportError(tokens, token.offset, "missing components while parsing color");
+            return Node();
+        }
+        return Node(ToColor(tokens.GetText(token), values[0], values[1], values[2]));
+    }
 
-        if(!token->Is(TokenType::LEFT_BRACE))
-            throw std::runtime_error("error: unexpected token while parsing range.");
+    // Handle RANGE keyword by generating a list of the numbers between A and B
+    // as in: RANGE { A  B }
+    if(token.Is(TokenType::IDENTIFIER) && tokens.GetText(token) == "RANGE") {
+        if(tokens.Empty() || !tokens.Peek().Is(TokenType::LEFT_BRACE)) {
+            ReportError(tokens, token.offset, "missing block after RANGE");
+            return Node();
+        }
 
+        // Remove LEFT_BRACE token from the list.
+        tokens.Next();
         return ParseRange(tokens);
     }
 
     // Skip LIST keyword.
-    if(token->Is(TokenType::IDENTIFIER) && std::get<std::string>(token->GetValue()) == "LIST") {
-        if(tokens.empty())
-            throw std::runtime_error("error: unexpected end while parsing list.");
+    if(token.Is(TokenType::IDENTIFIER) && tokens.GetText(token) == "LIST") {
+        if(tokens.Empty() || !tokens.Peek().Is(TokenType::LEFT_BRACE)) {
+            ReportError(tokens, token.offset, "missing block after LIST");
+            return Node();
+        }
 
         // Remove LEFT_BRACE token from the list.
-        token = tokens.front();
-        tokens.pop_front();
-
-        if(!token->Is(TokenType::LEFT_BRACE))
-            throw std::runtime_error("error: unexpected token while parsing list.");
+        tokens.Next();
     }
 
     // Handle simple/raw values such as number, bool, string...
-    else if(!token->Is(TokenType::LEFT_BRACE)) {
+    else if(!token.Is(TokenType::LEFT_BRACE)) {
         return ParseRaw(token, tokens);
     }
 
+    return ParseBlock(tokens);
+}
+
+Node Parser::Impl::ParseBlock(TokenStream& tokens) {
     // Handle lists: { 1 2 3 4 5 }
-    // Check if two successive tokens are of the same type.
-    // So, if there isn't any operators for the second tokens,
-    // it has to be a list.
     if(IsList(tokens)) {
-        // The current token, which is LEFT_BRACE, won't be useful, so we can discard it.
-        token = tokens.front();
+        CompactToken first = tokens.Peek();
 
-        if(token->Is(TokenType::NUMBER))
+        if(first.Is(TokenType::NUMBER))
             return ParseList<double>(tokens);
         
-        if(token->Is(TokenType::IDENTIFIER) || token->Is(TokenType::STRING))
+        if(first.Is(TokenType::IDENTIFIER) || first.Is(TokenType::STRING))
             return ParseList<std::string>(tokens);
     }
     
-    return Parse(tokens);
-    // throw std::runtime_error("error: failed to parse node value.");
+    return ParseEntries(tokens, true);
+}
+
+void Parser::Impl::SkipNode(TokenStream& tokens) {
+    CompactToken token = tokens.Next();
+
+    // Skip the RANGE and LIST keywords, and the prefixes of colors.
+    if(token.Is(TokenType::IDENTIFIER) && !tokens.Empty() && tokens.Peek().Is(TokenType::LEFT_BRACE)) {
+        std::string_view text = tokens.GetText(token);
+        if(text == "RANGE" || text == "LIST")
+            token = tokens.Next();
+    }
+    else if(token.Is(TokenType::COLOR) && !tokens.Empty()) {
+        token = tokens.Next();
+    }
+
+    if(token.Is(TokenType::LEFT_BRACE)) {
+        int depth = 1;
+        while(depth > 0 && !tokens.Empty()) {
+            token = tokens.Next();
+            if(token.Is(TokenType::LEFT_BRACE))
+                depth++;
+            else if(token.Is(TokenType::RIGHT_BRACE))
+                depth--;
+        }
+        if(depth > 0)
+            ReportError(tokens, tokens.GetEnd(), "missing closing brace at the end of the block");
+        return;
+    }
+
+    // Skip the second part of scoped strings: "scope:value"
+    if(token.Is(TokenType::IDENTIFIER) && tokens.Has(2) && tokens.Peek(0).Is(TokenType::TWO_DOTS) && tokens.Peek(1).Is(TokenType::IDENTIFIER)) {
+        tokens.Next();
+        tokens.Next();
+    }
 }
 
-Node Parser::Impl::ParseRaw(PToken token, std::deque<PToken>& tokens) {
-    switch(token->GetType()) {
+Node Parser::Impl::ParseRaw(const CompactToken& token, TokenStream& tokens) {
+    switch(token.type) {
         case TokenType::BOOLEAN:
-            return Node(std::get<bool>(token->GetValue()));
+            return Node(token.boolean);
         case TokenType::DATE:
-            return Node(std::get<Date>(token->GetValue()));
+            return Node(token.GetDate());
         case TokenType::IDENTIFIER:
             return ParseIdentifier(token, tokens);
         case TokenType::NUMBER:
-            return Node(std::get<double>(token->GetValue()));
+            return Node(token.number);
         case TokenType::STRING:
-            return Node(std::get<std::string>(token->GetValue()));
+            return Node(Symbol(tokens.GetText(token)));
         default:
-            throw std::runtime_error("error: unexpected token while parsing value.");
+            ReportError(tokens, token.offset, "unexpected token while parsing value");
+            return Node();
     }
 }
 
-Node Parser::Impl::ParseIdentifier(PToken token, std::deque<PToken>& tokens) {
-    if(!token->Is(TokenType::IDENTIFIER))
+Node Parser::Impl::ParseIdentifier(const CompactToken& token, TokenStream& tokens) {
+    if(!token.Is(TokenType::IDENTIFIER))
         throw std::runtime_error("error: unexpected token while parsing string.");
 
-    std::string firstValue = std::get<std::string>(token->GetValue());
-
     // Check if the token is a scope such as in: "scope:value"
-    if(tokens.size() < 2 || !tokens.at(0)->Is(TokenType::TWO_DOTS) || !tokens.at(1)->Is(TokenType::IDENTIFIER))
-        return Node(firstValue);
+    if(!tokens.Has(2) || !tokens.Peek(0).Is(TokenType::TWO_DOTS) || !tokens.Peek(1).Is(TokenType::IDENTIFIER))
+        return Node(Symbol(tokens.GetText(token)));
 
-    std::string secondValue = std::get<std::string>(tokens.at(1)->GetValue());
-    tokens.pop_front();
-    tokens.pop_front();
+    tokens.Next();
+    CompactToken second = tokens.Next();
     
-    return Node(ScopedString(firstValue, secondValue));
+    return Node(ScopedString(std::string(tokens.GetText(token)), std::string(tokens.GetText(second))));
 }
 
-Node Parser::Impl::ParseRange(std::deque<PToken>& tokens) {
-    
-    // First, check if the first two tokens are numbers
-    // and initialize the minimum and maximum between
-    // the two, as default for the range.
-    if(tokens.size() < 3)
-        throw std::runtime_error("error: unexpected end while parsing range.");
-    
-    PToken firstToken = tokens.at(0);
-    PToken secondToken = tokens.at(1);
-    
-    tokens.pop_front();
-    tokens.pop_front();
-
-    if(!firstToken->Is(TokenType::NUMBER) || !secondToken->Is(TokenType::NUMBER))
-        throw std::runtime_error("error: unexpected token while parsing range.");
-
-    if(tokens.empty())
-        throw std::runtime_error("error: unexpected end while parsing list.");
+Node Parser::Impl::ParseRange(TokenStream& tokens) {
+    // Loop over the list and keep the minimum and the maximum
+    // of the range, whose numbers are never expanded.
+    int min = std::numeric_limits<int>::max(), max = std::numeric_limits<int>::min();
+    int count = 0;
+    std::size_t start = tokens.GetEnd();
 
-    int first = (int) std::get<double>(firstToken->GetValue());
-    int second = (int) std::get<double>(secondToken->GetValue());
-    int min = std::min(first, second), max = std::max(first, second);
+    while(true) {
+        if(tokens.Empty()) {
+            ReportError(tokens, tokens.GetEnd(), "unexpected end while parsing range");
+            break;
+        }
+        CompactToken token = tokens.Next();
+        if(token.Is(TokenType::RIGHT_BRACE))
+            break;
 
-    // Loop over the list and keep the minimum and the maximum,
-    // then generate a list/vector of all the numbers in that range.
-    PToken token;
+        if(!token.Is(TokenType::NUMBER)) {
+            SkipUnexpected(tokens, token, "unexpected token while parsing range");
+            continue;
+        }
 
-    // The RIGHT_BRACE token must be removed from the list before returning.
-    // The first token exists because the size of the list has been checked
-    // at the beginning of the function.
-    token = tokens.front();
-    tokens.pop_front();
-
-    while(!token->Is(TokenType::RIGHT_BRACE)) {
-        if(!token->Is(TokenType::NUMBER))
-            throw std::runtime_error("error: unexpected token while parsing range.");
-        
-        int n = (int) std::get<double>(token->GetValue());
+        int n = (int) token.number;
         min = std::min(min, n);
         max = std::max(max, n);
-
-        if(tokens.empty())
-            throw std::runtime_error("error: unexpected end while parsing range.");
-        
-        token = tokens.front();
-        tokens.pop_front();
+        count++;
     }
 
-    std::vector<double> list;
-    for(int i = min; i <= max; i++)
-        list.push_back((double) i);
-
-    return Node(list);
+    if(count < 2)
+        ReportError(tokens, start, "missing bounds while parsing range");
+    if(count == 0)
+        return Node();
+    return Node(IntervalList(min, max));
 }
 
 template<typename T>
-Node Parser::Impl::ParseList(std::deque<PToken>& tokens) {
+Node Parser::Impl::ParseList(TokenStream& tokens) {
     std::vector<T> list;
-    PToken token;
     
     // The RIGHT_BRACE token must be removed from the list before returning.
-    token = tokens.front();
-    tokens.pop_front();
-
-    while(!token->Is(TokenType::RIGHT_BRACE)) {
-        list.push_back(std::get<T>(token->GetValue()));
+    while(true) {
+        if(tokens.Empty()) {
+            ReportError(tokens, tokens.GetEnd(), "unexpected end while parsing list");
+            break;
+        }
+        CompactToken token = tokens.Next();
+        if(token.Is(TokenType::RIGHT_BRACE))
+            break;
 
-        if(tokens.empty())
-            throw std::runtime_error("error: unexpected end while parsing list.");
-        
-        token = tokens.front();
-        tokens.pop_front();
+        if constexpr (std::is_same_v<T, double>) {
+            if(!token.Is(TokenType::NUMBER)) {
+                SkipUnexpected(tokens, token, "unexpected token while parsing list");
+                continue;
+            }
+            list.push_back(token.number);
+        }
+        else {
+            if(!token.Is(TokenType::IDENTIFIER) && !token.Is(TokenType::STRING)) {
+                SkipUnexpected(tokens, token, "unexpected token while parsing list");
+                continue;
+            }
+            list.push_back(T(tokens.GetText(token)));
+        }
     }
     
     return Node(list);
 }
-    
-bool Parser::Impl::IsList(std::deque<PToken>& tokens) {
-    if(tokens.size() < 2)
-        return false;
 
-    PToken firstToken = tokens.at(0);
-    PToken secondToken = tokens.at(1);
+bool Parser::Impl::IsList(TokenStream& tokens) {
+    if(!tokens.Has(2))
+        return false;
 
-    #define IS_LIST_TYPE(t) (t->Is(TokenType::IDENTIFIER) || t->Is(TokenType::NUMBER) || t->Is(TokenType::STRING))
+    CompactToken firstToken = tokens.Peek(0);
+    CompactToken secondToken = tokens.Peek(1);
 
     // Check if two successive tokens are of the same type.
-    // So, if there isn't any operators for the second tokens,
-    // it has to be a list.
-
     // Or if there is only an element in the list, check if the second
     // token is a RIGHT_BRACE.
-    return (secondToken->Is(firstToken->GetType()) && IS_LIST_TYPE(secondToken))
-        || (secondToken->Is(TokenType::RIGHT_BRACE) && IS_LIST_TYPE(firstToken));
+    auto isListType = [](const CompactToken& t) {
+        return t.Is(TokenType::IDENTIFIER) || t.Is(TokenType::NUMBER) || t.Is(TokenType::STRING);
+    };
+    return (secondToken.Is(firstToken.type) && isListType(secondToken))
+        || (secondToken.Is(TokenType::RIGHT_BRACE) && isListType(firstToken));
 }
 
-void Parser::Benchmark() {
-    sf::Clock clock;
-
-    // std::string filePath = "test_mod/map_data/default.map";
-    std::string filePath = "test_mod/parser_test.txt";
-
-    // std::string filePath = "test_mod/map_data/island_region.txt";
-    // std::string filePath = "test_mod/map_data/geographical_regions/00_agot_geographical_region.txt";
-    // std::string filePath = "test_mod/history/characters/00_agot_char_vale_ancestors.txt";
-
-    std::ifstream file(filePath);
-
-    std::string content = File::ReadString(file);
-    file.close();
-    
-    sf::Time elapsedFile = clock.restart();
-
-    std::deque<PToken> tokens = Parser::Lex(content);
-    int tokensCount = tokens.size();
-
-    sf::Time elapsedLexer = clock.restart();
-
-    Node result = Parser::Parse(tokens);
-    sf::Time elapsedParser = clock.getElapsedTime();
-
-    fmt::println("file path = {}", filePath);
-    fmt::println("file size = {}", String::FileSizeFormat(std::filesystem::file_size(filePath)));
-    fmt::println("tokens = {}", tokensCount);
-    fmt::println("entries = {}", result.GetEntries().size());
-    fmt::println("elapsed file   = {}", String::DurationFormat(elapsedFile));
-    fmt::println("elapsed lexer  = {}", String::DurationFormat(elapsedLexer));
-    fmt::println("elapsed parser = {}", String::DurationFormat(elapsedParser));
-    fmt::println("elapsed total  = {}", String::DurationFormat(elapsedFile + elapsedLexer + elapsedParser));
-
-    // Display the result.
-    fmt::println("\n------------------RESULT--------------------\n");
-    fmt::println("{}", result);
-    fmt::println("\n--------------------------------------------\n");
-
-    ///////////////////////////
-    // Test default.map file //
-    ///////////////////////////
-    
-    if(filePath == "test_mod/map_data/default.map") {
-        fmt::println("\nlakes = {}", result.Get("lakes"));
-        fmt::println("\nisland_region => {}", result.Get("island_region"));
-    }
-
-    ///////////////////////////////
-    // Test parser_test.txt file //
-    ///////////////////////////////
-
-    if(filePath == "test_mod/parser_test.txt") {
-        // Test number list.
-        fmt::println("\nlist = {}", result.Get("list"));
-            
-        // Test range.
-        fmt::println("\nrange = {}", result.Get("range"));
-        
-        // Test string list.
-        fmt::println("\nstring_list = {}", result.Get("string_list"));
-        
-        // Test for single raw values.
-        fmt::println("\nidentifier => {}", result.Get("identifier"));
-        fmt::println("string => {}", result.Get("string"));
-        fmt::println("number => {}", result.Get("number"));
-        fmt::println("bool => {}", result.Get("bool"));
-        fmt::println("date => {}", result.Get("date"));
-        fmt::println("scope:value => {}", result.Get(ScopedString("scope", "value")));
-        // fmt::println("scope => {}", (ScopedString) result.Get("scope"));
-        
-        // Test date as key
-        fmt::println("1000.1.1 => {}", result.Get(Date(1000, 1, 1)));
-        
-        // Test utf8 characters as value
-        fmt::println("utf8 => {}", result.Get("utf8"));
-
-        // Test depth
-        fmt::println("depth: {}", result.Get("depth").GetDepth());
-        fmt::println("depth.name: {} {}", result.Get("depth").Get("name"), result.Get("depth").Get("name").GetDepth());
-        fmt::println("depth.1: {}", result.Get("depth").Get(1.0).GetDepth());
-        fmt::println("depth.1.name: {} {}", result.Get("depth").Get(1.0).Get("name"), result.Get("depth").Get(1.0).Get("name").GetDepth());
-        fmt::println("depth.1.2: {}", result.Get("depth").Get(1.0).Get(2.0).GetDepth());
-        fmt::println("depth.1.2.name: {} {}", result.Get("depth").Get(1.0).Get(2.0).Get("name"), result.Get("depth").Get(1.0).Get(2.0).Get("name").GetDepth());
-        fmt::println("depth.1.3: {}", result.Get("depth").Get(1.0).Get(2.0).Get(3.0).GetDepth());
-        fmt::println("depth.1.3.name: {} {}", result.Get("depth").Get(1.0).Get(2.0).Get(3.0).Get("name"), result.Get("depth").Get(1.0).Get(2.0).Get(3.0).Get("name").GetDepth());
-        
-        fmt::println("operators = {}", result.Get("operators"));
-    }
-}
\ No newline at end of file
+sf::Color Parser::Impl::ToColor(std::string_view prefix, double a, double b, double c) {
+    // hsv components are between 0 and 1, whereas the hue
+    // of hsv360 is in degrees and the others in percents.
+    if(prefix == "hsv")
+        return sf::HSVColor(a * 360.f, b, c);
+    if(prefix == "hsv360")
+        return sf::HSVColor(a, b / 100.f, c / 100.f);
+    return sf::Color((int) a, (int) b, (int) c);
+}
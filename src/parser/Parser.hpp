@@ -3,11 +3,14 @@
 #include "parser/Lexer.hpp"
 
 #include <fmt/format.h>
+#include <memory_resource>
 #include <ranges>
 
 namespace Parser {
-    using Key = std::variant<double, std::string, Date, ScopedString>;
-    using RawValue = std::variant<double, bool, std::string, Date, ScopedString, std::vector<double>, std::vector<bool>, std::vector<std::string>>;
+    // Identifiers and strings are interned as symbols, except in lists.
+    // Lists written with RANGE are kept as runs of integers instead of being expanded.
+    using Key = std::variant<double, Symbol, Date, ScopedString>;
+    using RawValue = std::variant<double, bool, Symbol, Date, ScopedString, std::vector<double>, std::vector<bool>, std::vector<std::string>, IntervalList>;
 
     enum class Operator {
         EQUAL,
@@ -15,6 +18,8 @@ namespace Parser {
         LESS_EQUAL,
         GREATER,
         GREATER_EQUAL,
+        NOT_EQUAL,
+        QUESTION_EQUAL,
     };
     std::string OperatorToString(Operator op);
 
@@ -27,25 +32,122 @@ namespace Parser {
         NUMBER_LIST,
         BOOL_LIST,
         STRING_LIST,
+        RANGE_LIST,
         NODE
     };
 
+    class Node;
+    using Entry = std::pair<Key, std::pair<Operator, Node>>;
+
+    // Entries of a node kept in their insertion order. Small objects
+    // are searched linearly and a hashed index is only built once they
+    // grow past a few keys.
+    class Entries {
+        public:
+            using iterator = std::pmr::vector<Entry>::iterator;
+            using const_iterator = std::pmr::vector<Entry>::const_iterator;
+            using allocator_type = std::pmr::polymorphic_allocator<Entry>;
+
+            static constexpr std::size_t IndexThreshold = 16;
+
+            Entries(allocator_type allocator = {});
+            Entries(const Entries& entries, allocator_type allocator = {});
+
+            Entries& operator=(const Entries& entries);
+
+            iterator begin();
+            iterator end();
+            const_iterator begin() const;
+            const_iterator end() const;
+
+            std::size_t size() const;
+            bool empty() const;
+
+            iterator find(const Key& key);
+            const_iterator find(const Key& key) const;
+            std::size_t count(const Key& key) const;
+
+            // Insert an empty node at the end if the key doesn't exist yet.
+            std::pair<Operator, Node>& operator[](const Key& key);
+            iterator erase(iterator it);
+
+        private:
+            std::size_t IndexOf(const Key& key) const;
+            void BuildIndex();
+
+        private:
+            std::pmr::vector<Entry> m_Entries;
+            std::pmr::unordered_map<Key, uint32_t> m_Index;
+    };
+
+    // Memory block in which the node holders of a parsed file are allocated.
+    // It is freed once the last holder allocated from it is destroyed.
+    // The reference counter is not atomic: the nodes of a same arena
+    // must not be destroyed by several threads at the same time.
+    class Arena {
+        public:
+            Arena(std::size_t initialSize = 0);
+            Arena(const Arena&) = delete;
+            Arena& operator=(const Arena&) = delete;
+
+            std::pmr::memory_resource* GetResource();
+            void Retain();
+            void Release();
+
+            // Arena used by the current thread to allocate new holders,
+            // or nullptr if they have to be allocated on the heap.
+            static Arena* Current();
+
+            // Set the current arena until the scope is destroyed.
+            class Scope {
+                public:
+                    Scope(Arena* arena);
+                    Scope(const Scope&) = delete;
+                    ~Scope();
+
+                private:
+                    Arena* m_Arena;
+                    Arena* m_Previous;
+            };
+
+        private:
+            std::pmr::monotonic_buffer_resource m_Resource;
+            uint m_References;
+    };
+
+    // Nodes are copy-on-write: copying a node only shares the holder of its
+    // entries, which is copied the first time one of them is modified through
+    // a non-const function. The nested blocks stay shared until they are also
+    // modified, so a copy only costs the blocks written to.
+    // Like the arenas, the reference counters of the holders are not atomic:
+    // copies of a same node must not be made or destroyed by several threads
+    // at the same time.
+    // Blocks also cache a structural hash of their entries, which is shared by
+    // their copies and reset by the non-const functions of the path modified.
+    // Once a block returns a mutable reference to its entries (Get, GetEntries
+    // or operator[]), they may be modified later without it knowing, so its
+    // hash isn't cached anymore and copies of it get their own entries.
     class Node {
         public:
             Node();
             Node(const Node& node);
+            Node(Node&& node) noexcept;
             Node(const RawValue& value);
             Node(const sf::Color& color);
-            Node(const std::map<Key, std::pair<Operator, Node>>& values);
+            Node(const Entries& values);
+            ~Node();
 
             ValueType GetType() const;
             bool Is(ValueType type) const;
             bool IsList() const;
 
-            uint GetDepth() const;
-            void SetDepth(uint depth);
+            // Hash of the keys, operators and values of the node and of all
+            // its nested blocks, stable across runs. Only the blocks modified
+            // since the last call, or whose entries were returned by
+            // reference, are hashed again.
+            uint64_t GetHash() const;
 
-            // Functions to use with LeafHolder.
+            // Functions to use with leaf nodes.
             void Push(const RawValue& value);
 
             // Functions to use with NodeHolder.
@@ -53,103 +155,179 @@ namespace Parser {
             const Node& Get(const Key& key) const;
             template <typename T> T Get(const Key& key, T defaultValue) const;
             Operator GetOperator(const Key& key);
-            std::map<Key, std::pair<Operator, Node>>& GetEntries();
-            const std::map<Key, std::pair<Operator, Node>>& GetEntries() const;
+            Entries& GetEntries();
+            const Entries& GetEntries() const;
             std::vector<Key> GetKeys() const;
             bool ContainsKey(const Key& key) const;
             void Put(const Key& key, const Node& node, Operator op = Operator::EQUAL);
+            void Put(const Key& key, Node&& node, Operator op = Operator::EQUAL);
             void Put(const Key& key, const RawValue& value, Operator op = Operator::EQUAL);
+            // Put the value, or push it to the existing list if the key is
+            // already used, as done for duplicated keys when parsing.
+            // Return false if the values aren't of the same base type, such
+            // as a number and a block, in which case the first one is kept.
+            bool Append(const Key& key, const Node& node, Operator op = Operator::EQUAL);
+            bool Append(const Key& key, Node&& node, Operator op = Operator::EQUAL);
             Node Remove(const Key& key);
 
-            // Overload cast for LeafHolder.
+            // Overload cast for leaf nodes.
             operator int() const;
             operator double() const;
             operator bool() const;
             operator std::string() const;
+            operator Symbol() const;
             operator Date() const;
             operator ScopedString() const;
             operator std::vector<double>&() const;
             operator std::vector<bool>&() const;
             operator std::vector<std::string>&() const;
+            // Numbers and lists of numbers are converted to runs too.
+            operator IntervalList() const;
             operator RawValue&() const;
             operator Key() const;
             operator sf::Color() const;
 
             Node& operator=(const RawValue& value);
             Node& operator=(const Node& value);
+            Node& operator=(Node&& value) noexcept;
 
             Node& operator [](const Key& key);
             const Node& operator [](const Key& key) const;
         
         private:
-            // Function to access the underlying value holder.
-            SharedPtr<NodeHolder> GetNodeHolder();
-            const SharedPtr<NodeHolder> GetNodeHolder() const;
+            // Function to access the underlying values.
+            // The holder of an empty node is only allocated when needed,
+            // and a shared holder is copied before being modified.
+            NodeHolder& GetNodeHolder();
+            // Same, for a holder whose entries are returned by reference.
+            NodeHolder& ExposeNodeHolder();
+            const NodeHolder* GetNodeHolder() const;
+            RawValue& GetLeaf() const;
 
-            SharedPtr<LeafHolder> GetLeafHolder();
-            const SharedPtr<LeafHolder> GetLeafHolder() const;
+            void Reset();
 
         private:
-            SharedPtr<AbstractValueHolder> m_Value;
-            uint m_Depth;
-    };
-
-    class AbstractValueHolder {
-        public:
-            virtual ValueType GetType() const = 0;
-            virtual SharedPtr<AbstractValueHolder> Copy() const = 0;
-            virtual void SetDepth(uint depth) = 0;
+            // Leaf values are stored inline whereas nodes
+            // only point to the holder of their entries.
+            union {
+                RawValue m_Value;
+                NodeHolder* m_Holder;
+            };
+            bool m_IsNode;
     };
 
-    class NodeHolder : public AbstractValueHolder {
+    class NodeHolder {
         friend Node;
 
         public:
-            NodeHolder();
-            NodeHolder(const NodeHolder& n);
-            NodeHolder(const std::map<Key, std::pair<Operator, Node>>& values);
-
-            virtual ValueType GetType() const;
-            virtual SharedPtr<AbstractValueHolder> Copy() const;
-            virtual void SetDepth(uint depth);
+            NodeHolder(Arena* arena);
+            NodeHolder(Arena* arena, const Entries& values);
+            NodeHolder(const NodeHolder&) = delete;
+
+            // Holders are allocated in the current arena if there is one.
+            static NodeHolder* Create();
+            static NodeHolder* Create(const Entries& values);
+            // Holder to use for a copy of a node, shared unless it is exposed.
+            static NodeHolder* Share(NodeHolder* holder);
+            // Destroy the holder once the last node sharing it releases it.
+            static void Release(NodeHolder* holder);
 
         private:
-            std::map<Key, std::pair<Operator, Node>> m_Values;
+            Arena* m_Arena;
+            Entries m_Values;
+            uint m_References;
+            mutable uint64_t m_Hash;
+            mutable bool m_IsHashed;
+            // Set once a mutable reference to the entries has been returned.
+            // Such a holder isn't shared by copies, which get their own.
+            bool m_IsExposed;
     };
 
-    class LeafHolder : public AbstractValueHolder {
-        friend Node;
 
+    // Read the top-level entries of a file one at a time. The file is lexed
+    // chunk by chunk, so the memory used doesn't depend on the size of the file
+    // but only on the entries kept by the caller. Unlike Parse, entries with
+    // the same key are returned separately instead of being merged.
+    class EntryStream {
         public:
-            LeafHolder();
-            LeafHolder(const LeafHolder& l);
-            LeafHolder(const RawValue& value);
+            EntryStream(const std::string& filePath);
+            EntryStream(const EntryStream&) = delete;
 
-            virtual ValueType GetType() const;
-            virtual SharedPtr<AbstractValueHolder> Copy() const;
-            virtual void SetDepth(uint depth);
+            // Return false once the end of the file is reached.
+            bool Next(Key& key, Operator& op, Node& value);
 
         private:
-            RawValue m_Value;
+            std::ifstream m_File;
+            TokenStream m_Tokens;
+    };
+
+    // Receive the entries of a file as events instead of a node tree,
+    // so that nodes are only built for the values the visitor keeps.
+    class Visitor {
+        public:
+            enum class Action {
+                // Visit the entries of the block between OnBeginBlock and OnEndBlock.
+                // Values which aren't blocks are passed to OnValue.
+                DESCEND,
+                // Parse the whole value and pass it to OnValue.
+                MATERIALIZE,
+                // Skip the value without building any node.
+                SKIP,
+                // Let OnDecode read the value straight from the tokens.
+                DECODE,
+            };
+
+            virtual ~Visitor() = default;
+
+            // The offset is that of the key in the content of the tokens.
+            virtual Action OnKey(const Key& key, Operator op, std::size_t offset) = 0;
+            // The value can be moved from, it is discarded afterwards.
+            // The span covers the whole entry, from its key to the end of the value.
+            virtual void OnValue(const Key& key, Operator op, Node& value, Span span) {}
+            virtual void OnBeginBlock(const Key& key, Operator op) {}
+            // The span covers the whole entry, from its key to the closing brace.
+            virtual void OnEndBlock(const Key& key, Span span) {}
+            // Must consume the whole value, which is skipped by default.
+            virtual void OnDecode(const Key& key, Operator op, TokenStream& tokens);
     };
 
+    Node Parse(const std::string& filePath);
+    Node Parse(TokenStream& tokens);
+    // Lex and parse the chunks of the content on several threads. Their entries
+    // are merged in order, so the result is the same as parsing it at once.
+    Node ParseParallel(std::string_view content);
 
-    Node Parse(const std::string& content);
-    Node Parse(std::deque<PToken>& tokens, uint depth = 0);
+    // Unlike Parse, entries with the same key are visited separately.
+    void Visit(const std::string& filePath, Visitor& visitor);
+    void Visit(TokenStream& tokens, Visitor& visitor);
 
     namespace Impl {
-        Node ParseNode(std::deque<PToken>& tokens);
-        Node ParseRaw(PToken token, std::deque<PToken>& tokens);
-        Node ParseIdentifier(PToken token, std::deque<PToken>& tokens);
-        Node ParseRange(std::deque<PToken>& tokens);
+        // Parse the next "key operator value" entry of a block. Return false
+        // at the end of the block (its closing brace is consumed) or of the stream.
+        // Outside of any block, closing braces are reported and skipped, whereas
+        // the end of the stream inside a block is reported as a missing brace.
+        bool ParseEntry(TokenStream& tokens, Key& key, Operator& op, Node& value, bool inBlock);
+        // Append the entry to the values, and report an error at the offset
+        // of the key if it can't be merged with a previous one of the same key.
+        void AppendEntry(Node& values, const Key& key, Node&& value, Operator op, std::string_view content, std::size_t offset);
+        bool ParseKey(TokenStream& tokens, Key& key, Operator& op, bool inBlock);
+        Node ParseNode(TokenStream& tokens);
+        // Parse the content of a block after its opening brace.
+        Node ParseBlock(TokenStream& tokens);
+        void SkipNode(TokenStream& tokens);
+        Node ParseRaw(const CompactToken& token, TokenStream& tokens);
+        Node ParseIdentifier(const CompactToken& token, TokenStream& tokens);
+        Node ParseRange(TokenStream& tokens);
 
         template<typename T>
-        Node ParseList(std::deque<PToken>& tokens);
+        Node ParseList(TokenStream& tokens);
 
-        bool IsList(std::deque<PToken>& tokens);
-    }
+        bool IsList(TokenStream& tokens);
 
-    void Benchmark();
+        // Convert the components of a color written with a prefix
+        // (rgb, hsv or hsv360) to a RGB color.
+        sf::Color ToColor(std::string_view prefix, double a, double b, double c);
+    }
 }
 
 ///////////////////////////////////////////
@@ -166,7 +344,7 @@ public:
     constexpr auto format(const Parser::Key& key, Context& ctx) const {
         switch(key.index()) {
             case 0: return format_to(ctx.out(), "{}", std::get<double>(key));
-            case 1: return format_to(ctx.out(), "{}", std::get<std::string>(key));
+            case 1: return format_to(ctx.out(), "{}", std::get<Symbol>(key));
             case 2: return format_to(ctx.out(), "{}", std::get<Date>(key));
             case 3: return format_to(ctx.out(), "{}", std::get<ScopedString>(key));
         }
@@ -189,7 +367,7 @@ public:
             case Parser::ValueType::BOOL:
                 return format_to(ctx.out(), "{}", (std::get<bool>(value) ? "yes" : "no"));
             case Parser::ValueType::STRING:
-                return format_to(ctx.out(), "{}", std::get<std::string>(value));
+                return format_to(ctx.out(), "{}", std::get<Symbol>(value));
             case Parser::ValueType::DATE:
                 return format_to(ctx.out(), "{}", std::get<Date>(value));
             case Parser::ValueType::SCOPED_STRING:
@@ -212,86 +390,10 @@ public:
                         return fmt::format("{}", v);
                     }), " ")
                 );
+            case Parser::ValueType::RANGE_LIST:
+                return format_to(ctx.out(), "{{ {} }}", fmt::join(std::get<IntervalList>(value), " "));
             default:
                 return format_to(ctx.out(), "");
         }
     }
 };
-
-template <>
-class fmt::formatter<Parser::Node> {
-public:
-    constexpr auto parse(format_parse_context& ctx) {
-        return ctx.begin();
-    }
-
-    template <typename Context>
-    constexpr auto format(const Parser::Node& node, Context& ctx) const {
-        if(node.Is(Parser::ValueType::NODE)) {
-            auto v = std::views::transform(node.GetEntries(), [](const auto& p) {
-                if(p.second.second.Is(Parser::ValueType::NUMBER_LIST))
-                    return formatNumbersList(p.first, p.second.second);
-                return fmt::format(
-                    "{}{} {} {}",
-                    std::string(p.second.second.GetDepth()-1, '\t'), // Indentation
-                    p.first, // Key
-                    Parser::OperatorToString(p.second.first), // Operator
-                    p.second.second // Value
-                );
-            });
-            if(node.GetDepth() == 0)
-                return format_to(ctx.out(), "{}", fmt::join(v, "\n"));
-            return format_to(ctx.out(), "{{\n{}\n{}}}", fmt::join(v, "\n"), std::string(node.GetDepth()-1, '\t'));
-        }
-        return format_to(ctx.out(), "{}", (Parser::RawValue&) node);
-    }
-
-    static std::string formatNumbersList(const Parser::Key& key, const Parser::Node& node) {
-        std::vector<double> l = node;
-        std::vector<double> loneNumbers;
-        std::string indent = std::string(node.GetDepth()-1, '\t');
-
-        // Sort the list by ascending order.
-        std::sort(l.begin(), l.end(), [=](double a, double b) { return a < b; });
-
-        // Make a list of the lines to build the list
-        // with LIST and RANGE depending on the values.
-        std::vector<std::string> lines;
-        int start = 0;
-        int current = 1;
-
-        while(current <= l.size()) {
-            // Count the number of elements in the current range and make
-            // a range only if there are at least 3 elements.
-            int n = current - start;
-            bool isFollowingStreak = (current < l.size() && l[current-1]+1 == l[current]);
-
-            // Push a new line if a streak is broken or if it is the last element of the vector.
-            if(!isFollowingStreak) {
-                if(n > 2) {
-                    lines.push_back(fmt::format("RANGE {{ {}  {} }}", l[start], l[current-1]));
-                }
-                else {
-                    for(int i = start; i < current; i++)
-                        loneNumbers.push_back(l[i]);
-                }
-                start = current;
-            }
-            current++;
-        }
-
-        if(!loneNumbers.empty()) {
-            lines.push_back(fmt::format("{{ {} }}", fmt::join(
-                std::views::transform(loneNumbers, [](const auto& v) {
-                    return fmt::format("{}", v);
-                }), " ")
-            ));
-        }
-
-        return fmt::format("{}", fmt::join(
-            std::views::transform(lines, [indent, key](const auto& line) {
-                return fmt::format("{}{} = {}", indent, key, line);
-            }), "\n")
-        );
-    }
-};
\ No newline at end of file
@@ -0,0 +1,295 @@
+#include "Query.hpp"
+
+#include <charconv>
+
+using namespace Parser;
+
+// Match the text against a pattern with the wildcards '*' and '?',
+// going back to the last '*' when the rest doesn't match.
+static bool MatchGlob(std::string_view pattern, std::string_view text) {
+    std::size_t p = 0, t = 0;
+    std::size_t star = std::string_view::npos, retry = 0;
+
+    while(t < text.size()) {
+        if(p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+            p++;
+            t++;
+        }
+        else if(p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            retry = t;
+        }
+        else if(star != std::string_view::npos) {
+            p = star + 1;
+            t = ++retry;
+        }
+        else {
+            return false;
+        }
+    }
+    while(p < pattern.size() && pattern[p] == '*')
+        p++;
+    return p == pattern.size();
+}
+
+// Build the key the parser would read from the text of a segment.
+static Key ParseLiteralKey(std::string_view text) {
+    std::size_t separator = text.find(':');
+    if(separator != std::string_view::npos)
+        return ScopedString(std::string(text.substr(0, separator)), std::string(text.substr(separator + 1)));
+
+    double number;
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), number);
+    if(error == std::errc() && end == text.data() + text.size())
+        return number;
+
+    int values[3];
+    const char* p = text.data();
+    const char* last = text.data() + text.size();
+    for(int i = 0; i < 3; i++) {
+        auto [next, error] = std::from_chars(p, last, values[i]);
+        if(error != std::errc() || (i < 2 && (next == last || *next != '.')) || (i == 2 && next != last))
+            return Symbol(text);
+        p = next + 1;
+    }
+    return Date(values[0], values[1], values[2]);
+}
+
+static uint32_t ParseTypes(std::string_view name) {
+    static const std::pair<std::string_view, uint32_t> types[] = {
+        {"number", 1 << (int) ValueType::NUMBER},
+        {"bool", 1 << (int) ValueType::BOOL},
+        {"string", 1 << (int) ValueType::STRING},
+        {"date", 1 << (int) ValueType::DATE},
+        {"scoped_string", 1 << (int) ValueType::SCOPED_STRING},
+        {"number_list", 1 << (int) ValueType::NUMBER_LIST},
+        {"bool_list", 1 << (int) ValueType::BOOL_LIST},
+        {"string_list", 1 << (int) ValueType::STRING_LIST},
+        {"range_list", 1 << (int) ValueType::RANGE_LIST},
+        {"list", (1 << (int) ValueType::NUMBER_LIST) | (1 << (int) ValueType::BOOL_LIST)
+               | (1 << (int) ValueType::STRING_LIST) | (1 << (int) ValueType::RANGE_LIST)},
+        {"node", 1 << (int) ValueType::NODE},
+    };
+    for(const auto& [typeName, mask] : types) {
+        if(typeName == name)
+            return mask;
+    }
+    throw std::runtime_error(fmt::format("error: unknown type '{}' in query.", name));
+}
+
+////////////////////////////////
+//    TokensVisitor class     //
+////////////////////////////////
+
+class Query::TokensVisitor : public Visitor {
+    public:
+        TokensVisitor(const Query& query, const Callback& callback)
+        : m_Query(query), m_Callback(callback), m_States({query.m_Start}), m_Next(0), m_Matched(false) {}
+
+        Action OnKey(const Key& key, Operator op, std::size_t offset) override {
+            m_Next = m_Query.Advance(m_States.back(), key, m_Matched);
+            if(m_Matched)
+                return Action::MATERIALIZE;
+            return m_Query.CanDescend(m_Next) ? Action::DESCEND : Action::SKIP;
+        }
+
+        void OnValue(const Key& key, Operator op, Node& value, Span span) override {
+            // Values which aren't blocks are also passed while descending.
+            if(!m_Matched)
+                return;
+            if(m_Query.Accepts(value.GetType()))
+                m_Callback(key, op, value);
+
+            // The entry is already built, so its own matches are found in the node.
+            if(m_Query.CanDescend(m_Next) && value.Is(ValueType::NODE))
+                m_Query.Run(value, m_Next, m_Callback);
+        }
+
+        void OnBeginBlock(const Key& key, Operator op) override {
+            m_States.push_back(m_Next);
+        }
+
+        void OnEndBlock(const Key& key, Span span) override {
+            m_States.pop_back();
+        }
+
+    private:
+        const Query& m_Query;
+        const Callback& m_Callback;
+        std::vector<State> m_States;
+        State m_Next;
+        bool m_Matched;
+};
+
+////////////////////////////////
+//        Query class         //
+////////////////////////////////
+
+Query::Query(std::string_view path)
+: m_Start(0), m_Types(~0u) {
+    std::size_t typeStart = path.find('[');
+    if(typeStart != std::string_view::npos) {
+        if(!path.ends_with(']') || path.find('/', typeStart) != std::string_view::npos)
+            throw std::runtime_error(fmt::format("error: invalid type filter in query '{}'.", path));
+        m_Types = ParseTypes(path.substr(typeStart + 1, path.size() - typeStart - 2));
+        path = path.substr(0, typeStart);
+    }
+
+    for(const std::string& pattern : String::Split(std::string(path), "/")) {
+        if(pattern.empty())
+            throw std::runtime_error(fmt::format("error: empty segment in query '{}'.", path));
+
+        Segment segment{Segment::Kind::LITERAL, pattern, Key()};
+        if(pattern == "**")
+            segment.kind = Segment::Kind::RECURSIVE;
+        else if(pattern == "*")
+            segment.kind = Segment::Kind::ANY;
+        else if(pattern.find_first_of("*?") != std::string::npos)
+            segment.kind = Segment::Kind::GLOB;
+        else
+            segment.key = ParseLiteralKey(pattern);
+        m_Segments.push_back(std::move(segment));
+    }
+
+    if(m_Segments.size() > MaxSegments)
+        throw std::runtime_error(fmt::format("error: too many segments in query '{}'.", path));
+    m_Start = this->Close(1);
+}
+
+std::vector<Query::Match> Query::Run(const Node& node) const {
+    std::vector<Match> matches;
+    this->Run(node, m_Start, [&](const Key& key, Operator op, const Node& value) {
+        matches.push_back(Match{&key, op, &value});
+    });
+    return matches;
+}
+
+void Query::Run(const Node& node, const Callback& callback) const {
+    this->Run(node, m_Start, callback);
+}
+
+void Query::Run(TokenStream& tokens, const Callback& callback) const {
+    TokensVisitor visitor(*this, callback);
+    Parser::Visit(tokens, visitor);
+}
+
+void Query::Run(const std::string& filePath, const Callback& callback) const {
+    TokensVisitor visitor(*this, callback);
+    Parser::Visit(filePath, visitor);
+}
+
+Query::State Query::Close(State state) const {
+    // A '**' segment can also match no block at all.
+    for(std::size_t i = 0; i < m_Segments.size(); i++) {
+        if((state & (State(1) << i)) && m_Segments[i].kind == Segment::Kind::RECURSIVE)
+            state |= State(1) << (i + 1);
+    }
+    return state;
+}
+
+Query::State Query::Advance(State state, const Key& key, bool& matched) const {
+    State next = 0;
+    matched = false;
+
+    // Only the keys which aren't symbols have to be formatted for globs.
+    std::string text;
+    std::string_view keyText;
+    bool isFormatted = false;
+
+    for(std::size_t i = 0; i < m_Segments.size(); i++) {
+        if(!(state & (State(1) << i)))
+            continue;
+        const Segment& segment = m_Segments[i];
+        bool isMatch = false;
+
+        switch(segment.kind) {
+            case Segment::Kind::LITERAL:
+                isMatch = (key == segment.key);
+                break;
+            case Segment::Kind::GLOB:
+                if(!isFormatted) {
+                    if(std::holds_alternative<Symbol>(key)) {
+                        keyText = std::get<Symbol>(key).Str();
+                    }
+                    else {
+                        text = std::visit([](const auto& value) { return fmt::format("{}", value); }, key);
+                        keyText = text;
+                    }
+                    isFormatted = true;
+                }
+                isMatch = MatchGlob(segment.pattern, keyText);
+                break;
+            case Segment::Kind::ANY:
+                isMatch = true;
+                break;
+            case Segment::Kind::RECURSIVE:
+                // Stay on the segment to match more blocks.
+                next |= State(1) << i;
+                isMatch = (i + 1 == m_Segments.size());
+                break;
+        }
+
+        if(!isMatch)
+            continue;
+        if(segment.kind != Segment::Kind::RECURSIVE)
+            next |= State(1) << (i + 1);
+        if(i + 1 == m_Segments.size())
+            matched = true;
+    }
+    return this->Close(next);
+}
+
+bool Query::Accepts(ValueType type) const {
+    return m_Types & (1u << (int) type);
+}
+
+bool Query::CanDescend(State state) const {
+    // The bit after the last segment only marks the matches.
+    return state & ((State(1) << m_Segments.size()) - 1);
+}
+
+bool Query::IsLiteral(State state) const {
+    for(std::size_t i = 0; i < m_Segments.size(); i++) {
+        if((state & (State(1) << i)) && m_Segments[i].kind != Segment::Kind::LITERAL)
+            return false;
+    }
+    return true;
+}
+
+void Query::Run(const Node& node, State state, const Callback& callback) const {
+    if(!node.Is(ValueType::NODE))
+        return;
+    const Entries& entries = node.GetEntries();
+
+    if(!this->IsLiteral(state)) {
+        for(const auto& [key, pair] : entries)
+            this->Visit(key, pair.first, pair.second, state, callback);
+        return;
+    }
+
+    // Look the keys up instead of going through all the entries.
+    for(std::size_t i = 0; i < m_Segments.size(); i++) {
+        if(!(state & (State(1) << i)))
+            continue;
+        // Several segments of the state may look for the same key.
+        bool isVisited = false;
+        for(std::size_t j = 0; j < i && !isVisited; j++)
+            isVisited = (state & (State(1) << j)) && m_Segments[j].key == m_Segments[i].key;
+        if(isVisited)
+            continue;
+
+        auto it = entries.find(m_Segments[i].key);
+        if(it != entries.end())
+            this->Visit(it->first, it->second.first, it->second.second, state, callback);
+    }
+}
+
+void Query::Visit(const Key& key, Operator op, const Node& value, State state, const Callback& callback) const {
+    bool matched;
+    State next = this->Advance(state, key, matched);
+
+    if(matched && this->Accepts(value.GetType()))
+        callback(key, op, value);
+    if(this->CanDescend(next))
+        this->Run(value, next, callback);
+}
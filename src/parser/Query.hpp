@@ -0,0 +1,69 @@
+#pragma once
+
+#include "parser/Parser.hpp"
+
+namespace Parser {
+    // Path over the keys of nested blocks, compiled once and then run
+    // on any number of nodes or files:
+    //     k_*/d_*/color          colors of the duchies of every kingdom
+    //     */culture[string]      cultures written as a single identifier
+    //     **/capital             capitals at any depth
+    // Each segment is matched against the keys with the wildcards '*' (any
+    // characters) and '?' (a single character), and a '**' segment matches
+    // any number of nested blocks. An optional type in brackets after the
+    // last segment only keeps the values of that type: number, bool, string,
+    // date, scoped_string, number_list, bool_list, string_list, range_list,
+    // list or node.
+    class Query {
+        public:
+            // Views of a matched entry, which point into the node queried.
+            struct Match {
+                const Key* key;
+                Operator op;
+                const Node* value;
+            };
+            using Callback = std::function<void(const Key& key, Operator op, const Node& value)>;
+
+            // Throw if the path is invalid.
+            Query(std::string_view path);
+
+            // The node must outlive the matches and not be modified meanwhile.
+            std::vector<Match> Run(const Node& node) const;
+            void Run(const Node& node, const Callback& callback) const;
+            // Run over the tokens, only building nodes for the values matched,
+            // which are only valid during the call to the callback.
+            void Run(TokenStream& tokens, const Callback& callback) const;
+            void Run(const std::string& filePath, const Callback& callback) const;
+
+        private:
+            // Segments are matched as a small automaton in which each bit
+            // of a state is the index of the next segment to match.
+            using State = uint64_t;
+            static constexpr std::size_t MaxSegments = 63;
+
+            struct Segment {
+                enum class Kind { LITERAL, GLOB, ANY, RECURSIVE };
+                Kind kind;
+                std::string pattern;
+                // Key matched by literal segments, looked up instead of compared.
+                Key key;
+            };
+
+            class TokensVisitor;
+
+            State Close(State state) const;
+            // State after the key, and whether its entry is itself a match.
+            State Advance(State state, const Key& key, bool& matched) const;
+            bool Accepts(ValueType type) const;
+            bool CanDescend(State state) const;
+            bool IsLiteral(State state) const;
+            void Run(const Node& node, State state, const Callback& callback) const;
+            void Visit(const Key& key, Operator op, const Node& value, State state, const Callback& callback) const;
+
+        private:
+            std::vector<Segment> m_Segments;
+            State m_Start;
+            // Bit mask of the value types accepted for the matches.
+            uint32_t m_Types;
+    };
+}
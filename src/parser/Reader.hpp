@@ -1,12 +1,15 @@
 #pragma once
 
+#include "parser/Scan.hpp"
+
 class Reader {
 public:
-    Reader(std::string value) {
+    // The reader only keeps a view over the content, the caller
+    // must keep the underlying buffer alive while reading.
+    Reader(std::string_view value, int cursor = 0) {
         m_Content = value;
-        m_CursorStart = 0;
-        m_Cursor = 0;
-        m_CursorLine = 1;
+        m_CursorStart = cursor;
+        m_Cursor = cursor;
     }
 
     bool IsEmpty() const {
@@ -18,30 +21,29 @@ public:
     }
 
     std::string End() const {
-        return m_Content.substr(m_CursorStart, m_Cursor - m_CursorStart);
+        return std::string(m_Content.substr(m_CursorStart, m_Cursor - m_CursorStart));
     }
 
     std::string At(int pos) const {
         int length = String::UTF8CharLength(m_Content[pos]);
-        return m_Content.substr(pos, length);
+        return std::string(m_Content.substr(pos, length));
     }
 
-    void CheckNewLine() {
-        if(m_Content.at(m_Cursor) == '\n')
-            m_CursorLine++;
+    // The bounds are checked by the callers (IsEmpty, Peek),
+    // so the content is indexed without any check here.
+    char Advance() {
+        return m_Content[m_Cursor++];
     }
 
-    char Advance() {
-        this->CheckNewLine();
-        return m_Content.at(m_Cursor++);
+    void Skip(std::size_t count) {
+        m_Cursor += count;
     }
 
     bool Match(char ch) {
         if(this->IsEmpty())
             return false;
-        if(m_Content.at(m_Cursor) != ch)
+        if(m_Content[m_Cursor] != ch)
             return false;
-        this->CheckNewLine();
         m_Cursor++;
         return true;
     }
@@ -49,35 +51,37 @@ public:
     char Peek() {
         if(this->IsEmpty())
             return '\0';
-        return m_Content.at(m_Cursor);
+        return m_Content[m_Cursor];
     }
     
     void SkipTo(char ch) {
-        while(!this->IsEmpty() && this->Peek() != ch) {
-            this->CheckNewLine();
-            m_Cursor++;
-        }
+        const char* begin = m_Content.data();
+        m_Cursor = Scan::Find(begin + m_Cursor, begin + m_Content.size(), ch) - begin;
     }
 
-    int GetCursor() const {
-        return m_Cursor;
+    void SkipWhitespaces() {
+        const char* begin = m_Content.data();
+        m_Cursor = Scan::SkipWhitespaces(begin + m_Cursor, begin + m_Content.size()) - begin;
     }
 
-    int GetLine() const {
-        return m_CursorLine;
+    int GetStart() const {
+        return m_CursorStart;
+    }
+
+    int GetCursor() const {
+        return m_Cursor;
     }
 
     std::size_t Length() const {
         return m_Content.size() - m_Cursor;
     }
 
-    std::string GetContent() const {
+    std::string_view GetContent() const {
         return m_Content;
     }
 
 private:
-    std::string m_Content;
+    std::string_view m_Content;
     int m_CursorStart;
     int m_Cursor;
-    int m_CursorLine;
 };
\ No newline at end of file
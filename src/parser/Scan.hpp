@@ -0,0 +1,164 @@
+#pragma once
+
+// Scanning kernels used by the Reader and the lexer to skip over
+// many bytes at once (whitespaces, comments, strings).
+// They process 32 bytes at a time with AVX2 or 16 bytes with SSE2
+// when available, and fall back to a scalar loop for the remaining bytes.
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+namespace Scan {
+    // Return the first occurrence of ch in [begin, end), or end if not found.
+    inline const char* Find(const char* begin, const char* end, char ch) {
+        const char* p = begin;
+
+        #if defined(__AVX2__)
+        const __m256i needle32 = _mm256_set1_epi8(ch);
+        for(; end - p >= 32; p += 32) {
+            __m256i chunk = _mm256_loadu_si256((const __m256i*) p);
+            uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle32));
+            if(mask != 0)
+                return p + __builtin_ctz(mask);
+        }
+        #endif
+
+        #if defined(__SSE2__)
+        const __m128i needle16 = _mm_set1_epi8(ch);
+        for(; end - p >= 16; p += 16) {
+            __m128i chunk = _mm_loadu_si128((const __m128i*) p);
+            uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle16));
+            if(mask != 0)
+                return p + __builtin_ctz(mask);
+        }
+        #endif
+
+        for(; p < end; p++) {
+            if(*p == ch)
+                return p;
+        }
+        return end;
+    }
+
+    // Return the first occurrence of any of the four characters in [begin, end),
+    // or end if not found. Pass the same character several times to look for less.
+    inline const char* FindAny(const char* begin, const char* end, char a, char b, char c, char d) {
+        const char* p = begin;
+
+        #if defined(__AVX2__)
+        const __m256i a32 = _mm256_set1_epi8(a), b32 = _mm256_set1_epi8(b);
+        const __m256i c32 = _mm256_set1_epi8(c), d32 = _mm256_set1_epi8(d);
+        for(; end - p >= 32; p += 32) {
+            __m256i chunk = _mm256_loadu_si256((const __m256i*) p);
+            __m256i matches = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(chunk, a32), _mm256_cmpeq_epi8(chunk, b32)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(chunk, c32), _mm256_cmpeq_epi8(chunk, d32))
+            );
+            uint32_t mask = _mm256_movemask_epi8(matches);
+            if(mask != 0)
+                return p + __builtin_ctz(mask);
+        }
+        #endif
+
+        #if defined(__SSE2__)
+        const __m128i a16 = _mm_set1_epi8(a), b16 = _mm_set1_epi8(b);
+        const __m128i c16 = _mm_set1_epi8(c), d16 = _mm_set1_epi8(d);
+        for(; end - p >= 16; p += 16) {
+            __m128i chunk = _mm_loadu_si128((const __m128i*) p);
+            __m128i matches = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, a16), _mm_cmpeq_epi8(chunk, b16)),
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, c16), _mm_cmpeq_epi8(chunk, d16))
+            );
+            uint32_t mask = _mm_movemask_epi8(matches);
+            if(mask != 0)
+                return p + __builtin_ctz(mask);
+        }
+        #endif
+
+        for(; p < end; p++) {
+            if(*p == a || *p == b || *p == c || *p == d)
+                return p;
+        }
+        return end;
+    }
+
+    // Return the first byte which isn't a whitespace (' ', '\t', '\r', '\n')
+    // in [begin, end), or end if there are only whitespaces.
+    inline const char* SkipWhitespaces(const char* begin, const char* end) {
+        const char* p = begin;
+
+        // Most of the time, only a few whitespaces separate two tokens,
+        // so check the first bytes before loading whole vectors.
+        for(int i = 0; i < 4 && p < end; i++, p++) {
+            if(*p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+                return p;
+        }
+
+        #if defined(__AVX2__)
+        const __m256i space32 = _mm256_set1_epi8(' '), tab32 = _mm256_set1_epi8('\t');
+        const __m256i cr32 = _mm256_set1_epi8('\r'), lf32 = _mm256_set1_epi8('\n');
+        for(; end - p >= 32; p += 32) {
+            __m256i chunk = _mm256_loadu_si256((const __m256i*) p);
+            __m256i spaces = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(chunk, space32), _mm256_cmpeq_epi8(chunk, tab32)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(chunk, cr32), _mm256_cmpeq_epi8(chunk, lf32))
+            );
+            uint32_t mask = ~(uint32_t) _mm256_movemask_epi8(spaces);
+            if(mask != 0)
+                return p + __builtin_ctz(mask);
+        }
+        #endif
+
+        #if defined(__SSE2__)
+        const __m128i space16 = _mm_set1_epi8(' '), tab16 = _mm_set1_epi8('\t');
+        const __m128i cr16 = _mm_set1_epi8('\r'), lf16 = _mm_set1_epi8('\n');
+        for(; end - p >= 16; p += 16) {
+            __m128i chunk = _mm_loadu_si128((const __m128i*) p);
+            __m128i spaces = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, space16), _mm_cmpeq_epi8(chunk, tab16)),
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, cr16), _mm_cmpeq_epi8(chunk, lf16))
+            );
+            uint32_t mask = ~(uint32_t) _mm_movemask_epi8(spaces) & 0xFFFF;
+            if(mask != 0)
+                return p + __builtin_ctz(mask);
+        }
+        #endif
+
+        for(; p < end; p++) {
+            if(*p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+                return p;
+        }
+        return end;
+    }
+
+    // Count the number of '\n' in [begin, end).
+    inline std::size_t CountNewLines(const char* begin, const char* end) {
+        const char* p = begin;
+        std::size_t count = 0;
+
+        #if defined(__AVX2__)
+        const __m256i lf32 = _mm256_set1_epi8('\n');
+        for(; end - p >= 32; p += 32) {
+            __m256i chunk = _mm256_loadu_si256((const __m256i*) p);
+            count += __builtin_popcount((uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, lf32)));
+        }
+        #endif
+
+        #if defined(__SSE2__)
+        const __m128i lf16 = _mm_set1_epi8('\n');
+        for(; end - p >= 16; p += 16) {
+            __m128i chunk = _mm_loadu_si128((const __m128i*) p);
+            count += __builtin_popcount((uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, lf16)));
+        }
+        #endif
+
+        for(; p < end; p++) {
+            if(*p == '\n')
+                count++;
+        }
+        return count;
+    }
+}
@@ -0,0 +1,97 @@
+#include "Schema.hpp"
+
+using namespace Parser;
+using namespace Parser::Impl;
+
+// Skip the value if its first token isn't of the expected type.
+static bool Expect(TokenStream& tokens, TokenType type) {
+    if(tokens.Empty())
+        return false;
+    if(tokens.Peek().Is(type))
+        return true;
+    SkipNode(tokens);
+    return false;
+}
+
+bool Parser::Impl::Decode(TokenStream& tokens, double& value) {
+    if(!Expect(tokens, TokenType::NUMBER))
+        return false;
+    value = tokens.Next().number;
+    return true;
+}
+
+bool Parser::Impl::Decode(TokenStream& tokens, int& value) {
+    if(!Expect(tokens, TokenType::NUMBER))
+        return false;
+    value = (int) tokens.Next().number;
+    return true;
+}
+
+bool Parser::Impl::Decode(TokenStream& tokens, bool& value) {
+    if(!Expect(tokens, TokenType::BOOLEAN))
+        return false;
+    value = tokens.Next().boolean;
+    return true;
+}
+
+bool Parser::Impl::Decode(TokenStream& tokens, Symbol& value) {
+    if(tokens.Empty())
+        return false;
+
+    // Scoped strings such as "scope:value" are not single symbols.
+    CompactToken token = tokens.Peek();
+    bool scoped = tokens.Has(2) && tokens.Peek(1).Is(TokenType::TWO_DOTS);
+    if((!token.Is(TokenType::IDENTIFIER) && !token.Is(TokenType::STRING)) || scoped) {
+        SkipNode(tokens);
+        return false;
+    }
+
+    tokens.Next();
+    value = Symbol(tokens.GetText(token));
+    return true;
+}
+
+bool Parser::Impl::Decode(TokenStream& tokens, std::string& value) {
+    Symbol symbol;
+    if(!Decode(tokens, symbol))
+        return false;
+    value = symbol.Str();
+    return true;
+}
+
+bool Parser::Impl::Decode(TokenStream& tokens, Date& value) {
+    if(!Expect(tokens, TokenType::DATE))
+        return false;
+    value = tokens.Next().GetDate();
+    return true;
+}
+
+bool Parser::Impl::Decode(TokenStream& tokens, sf::Color& value) {
+    // The components are in RGB unless another prefix is given.
+    std::string_view prefix = "rgb";
+    if(!tokens.Empty() && tokens.Peek().Is(TokenType::COLOR))
+        prefix = tokens.GetText(tokens.Next());
+
+    if(!Expect(tokens, TokenType::LEFT_BRACE))
+        return false;
+
+    // Look ahead until the closing brace so that
+    // an invalid color can still be skipped as a whole.
+    double components[3];
+    std::size_t n = 1;
+    while(tokens.Has(n + 1) && tokens.Peek(n).Is(TokenType::NUMBER)) {
+        if(n <= 3)
+            components[n - 1] = tokens.Peek(n).number;
+        n++;
+    }
+
+    if(n < 4 || !tokens.Has(n + 1) || !tokens.Peek(n).Is(TokenType::RIGHT_BRACE)) {
+        SkipNode(tokens);
+        return false;
+    }
+
+    for(std::size_t i = 0; i <= n; i++)
+        tokens.Next();
+    value = ToColor(prefix, components[0], components[1], components[2]);
+    return true;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "parser/Parser.hpp"
+
+#include <tuple>
+
+namespace Parser {
+    namespace Impl {
+        // Decode a value of the given type from the next tokens.
+        bool Decode(TokenStream& tokens, double& value);
+        bool Decode(TokenStream& tokens, int& value);
+        bool Decode(TokenStream& tokens, bool& value);
+        bool Decode(TokenStream& tokens, Symbol& value);
+        bool Decode(TokenStream& tokens, std::string& value);
+        bool Decode(TokenStream& tokens, Date& value);
+        bool Decode(TokenStream& tokens, sf::Color& value);
+    }
+
+    // Key of a block decoded straight from the tokens
+    // into a member of T, without building any node.
+    template <typename T, typename M>
+    struct Field {
+        std::string_view name;
+        M T::* member;
+    };
+
+    // Describe how the keys of a block map onto the members of T:
+    //     constexpr Parser::Schema schema {
+    //         Parser::Field{"color", &Data::color},
+    //         Parser::Field{"landless", &Data::landless},
+    //     };
+    // Fields can be of type double, int, bool, Symbol, std::string, Date or sf::Color.
+    template <typename T, typename ...M>
+    class Schema {
+        public:
+            static constexpr std::size_t Size = sizeof...(M);
+
+            constexpr Schema(Field<T, M> ...fields)
+            : m_Fields(fields...) {}
+
+            // Return the index of the field, or Size if there isn't any with that name.
+            constexpr std::size_t IndexOf(std::string_view name) const {
+                std::size_t index = 0, found = Size;
+                auto check = [&](const auto& field) {
+                    if(found == Size && field.name == name)
+                        found = index;
+                    index++;
+                };
+                std::apply([&](const auto& ...fields) { (check(fields), ...); }, m_Fields);
+                return found;
+            }
+
+            std::size_t IndexOfKey(const Key& key) const {
+                if(!std::holds_alternative<Symbol>(key))
+                    return Size;
+                return this->IndexOf(std::string_view(std::get<Symbol>(key).Str()));
+            }
+
+            constexpr std::string_view GetName(std::size_t index) const {
+                std::size_t i = 0;
+                std::string_view name;
+                auto check = [&](const auto& field) {
+                    if(i++ == index)
+                        name = field.name;
+                };
+                std::apply([&](const auto& ...fields) { (check(fields), ...); }, m_Fields);
+                return name;
+            }
+
+            // Decode the value of the field at index into the object.
+            // If the value doesn't match the type of the field, it is
+            // skipped and the member is left untouched.
+            bool Decode(std::size_t index, TokenStream& tokens, T& object) const {
+                std::size_t i = 0;
+                bool decoded = false;
+                auto decode = [&](const auto& field) {
+                    if(i++ == index)
+                        decoded = Impl::Decode(tokens, object.*(field.member));
+                };
+                std::apply([&](const auto& ...fields) { (decode(fields), ...); }, m_Fields);
+                return decoded;
+            }
+
+        private:
+            std::tuple<Field<T, M>...> m_Fields;
+    };
+}
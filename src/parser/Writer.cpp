@@ -0,0 +1,207 @@
+#include "Writer.hpp"
+
+using namespace Parser;
+
+Writer::Writer()
+: m_Stream(nullptr) {}
+
+Writer::Writer(std::ostream& stream)
+: m_Stream(&stream) {
+    m_Buffer.reserve(FlushSize + FlushSize / 4);
+}
+
+Writer::~Writer() {
+    this->Flush();
+}
+
+void Writer::Write(const Node& node) {
+    if(node.Is(ValueType::NODE)) {
+        for(const auto& [key, pair] : node.GetEntries())
+            this->WriteEntry(key, pair.first, pair.second);
+        return;
+    }
+    this->WriteRaw(node);
+    m_Buffer += '\n';
+}
+
+void Writer::WriteEntry(const Key& key, Operator op, const Node& value) {
+    this->WriteEntry(key, op, value, 0);
+    m_Buffer += '\n';
+}
+
+void Writer::WriteComment(std::string_view comment) {
+    m_Buffer += "# ";
+    m_Buffer += comment;
+    m_Buffer += '\n';
+}
+
+std::string_view Writer::GetContent() const {
+    return m_Buffer;
+}
+
+void Writer::Flush() {
+    if(m_Stream == nullptr || m_Buffer.empty())
+        return;
+    m_Stream->write(m_Buffer.data(), m_Buffer.size());
+    m_Buffer.clear();
+}
+
+void Writer::WriteEntries(const Node& node, uint depth) {
+    bool first = true;
+    for(const auto& [key, pair] : node.GetEntries()) {
+        if(!first)
+            m_Buffer += '\n';
+        this->WriteEntry(key, pair.first, pair.second, depth);
+        first = false;
+    }
+}
+
+void Writer::WriteEntry(const Key& key, Operator op, const Node& value, uint depth) {
+    if(value.Is(ValueType::RANGE_LIST)) {
+        this->WriteRangesList(key, std::get<IntervalList>((RawValue&) value), depth);
+    }
+    else {
+        this->WriteIndent(depth);
+        this->WriteKey(key);
+        m_Buffer += ' ';
+        m_Buffer += OperatorToString(op);
+        m_Buffer += ' ';
+        this->WriteValue(value, depth);
+    }
+
+    // Flush between entries so that a single big block
+    // doesn't have to be kept entirely in the buffer.
+    if(m_Stream != nullptr && m_Buffer.size() >= FlushSize)
+        this->Flush();
+}
+
+void Writer::WriteValue(const Node& value, uint depth) {
+    if(!value.Is(ValueType::NODE)) {
+        this->WriteRaw(value);
+        return;
+    }
+    m_Buffer += "{\n";
+    this->WriteEntries(value, depth + 1);
+    m_Buffer += '\n';
+    this->WriteIndent(depth);
+    m_Buffer += '}';
+}
+
+void Writer::WriteRaw(const RawValue& value) {
+    switch((ValueType) value.index()) {
+        case ValueType::NUMBER:
+            this->WriteNumber(std::get<double>(value));
+            break;
+        case ValueType::BOOL:
+            m_Buffer += std::get<bool>(value) ? "yes" : "no";
+            break;
+        case ValueType::STRING:
+            m_Buffer += std::get<Symbol>(value).Str();
+            break;
+        case ValueType::DATE:
+            fmt::format_to(std::back_inserter(m_Buffer), "{}", std::get<Date>(value));
+            break;
+        case ValueType::SCOPED_STRING:
+            fmt::format_to(std::back_inserter(m_Buffer), "{}", std::get<ScopedString>(value));
+            break;
+        case ValueType::NUMBER_LIST:
+            m_Buffer += "{ ";
+            for(std::size_t i = 0; i < std::get<std::vector<double>>(value).size(); i++) {
+                if(i > 0)
+                    m_Buffer += ' ';
+                this->WriteNumber(std::get<std::vector<double>>(value)[i]);
+            }
+            m_Buffer += " }";
+            break;
+        case ValueType::BOOL_LIST:
+            m_Buffer += "{ ";
+            for(std::size_t i = 0; i < std::get<std::vector<bool>>(value).size(); i++) {
+                if(i > 0)
+                    m_Buffer += ' ';
+                m_Buffer += std::get<std::vector<bool>>(value)[i] ? "yes" : "no";
+            }
+            m_Buffer += " }";
+            break;
+        case ValueType::STRING_LIST:
+            m_Buffer += "{ ";
+            for(std::size_t i = 0; i < std::get<std::vector<std::string>>(value).size(); i++) {
+                if(i > 0)
+                    m_Buffer += ' ';
+                m_Buffer += std::get<std::vector<std::string>>(value)[i];
+            }
+            m_Buffer += " }";
+            break;
+        case ValueType::RANGE_LIST: {
+            // Without a key to repeat, only a single run can be written as a range.
+            const IntervalList& list = std::get<IntervalList>(value);
+            if(list.GetIntervals().size() == 1 && list.GetSize() > 2) {
+                m_Buffer += "RANGE { ";
+                this->WriteNumber(list.GetIntervals()[0].first);
+                m_Buffer += "  ";
+                this->WriteNumber(list.GetIntervals()[0].last);
+                m_Buffer += " }";
+                break;
+            }
+            m_Buffer += "{ ";
+            bool first = true;
+            for(int32_t number : list) {
+                if(!first)
+                    m_Buffer += ' ';
+                this->WriteNumber(number);
+                first = false;
+            }
+            m_Buffer += " }";
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void Writer::WriteKey(const Key& key) {
+    if(std::holds_alternative<Symbol>(key))
+        m_Buffer += std::get<Symbol>(key).Str();
+    else
+        fmt::format_to(std::back_inserter(m_Buffer), "{}", key);
+}
+
+void Writer::WriteNumber(double number) {
+    fmt::format_to(std::back_inserter(m_Buffer), "{}", number);
+}
+
+void Writer::WriteRangesList(const Key& key, const IntervalList& list, uint depth) {
+    // Write the runs of at least 3 numbers with RANGE, one line per run,
+    // and a last line with the lone numbers.
+    IntervalList loneNumbers;
+    bool first = true;
+    auto writeLine = [&]() {
+        if(!first)
+            m_Buffer += '\n';
+        first = false;
+        this->WriteIndent(depth);
+        this->WriteKey(key);
+        m_Buffer += " = ";
+    };
+
+    for(const IntervalList::Interval& interval : list.GetIntervals()) {
+        if((int64_t) interval.last - interval.first < 2) {
+            loneNumbers.Add(interval.first, interval.last);
+            continue;
+        }
+        writeLine();
+        m_Buffer += "RANGE { ";
+        this->WriteNumber(interval.first);
+        m_Buffer += "  ";
+        this->WriteNumber(interval.last);
+        m_Buffer += " }";
+    }
+
+    if(!loneNumbers.Empty()) {
+        writeLine();
+        this->WriteRaw(loneNumbers);
+    }
+}
+
+void Writer::WriteIndent(uint depth) {
+    m_Buffer.append(depth, '\t');
+}
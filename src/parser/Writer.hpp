@@ -0,0 +1,68 @@
+#pragma once
+
+#include "parser/Parser.hpp"
+
+namespace Parser {
+    // Serialize nodes straight into a single buffer which is written to the
+    // stream in large chunks, instead of formatting each block into its own
+    // string. The indentation is computed while traversing the nodes.
+    class Writer {
+        public:
+            // The buffer is flushed once it grows past this size.
+            static constexpr std::size_t FlushSize = 1 << 20;
+
+            // Without a stream, the whole output is kept in the buffer.
+            Writer();
+            Writer(std::ostream& stream);
+            Writer(const Writer&) = delete;
+            ~Writer();
+
+            // Write the node as the content of a file: its entries
+            // on their own lines, or its value if it is a leaf.
+            void Write(const Node& node);
+            // Write a single entry at the root of the file.
+            void WriteEntry(const Key& key, Operator op, const Node& value);
+            // Write an entry nested at the given depth, without new line.
+            void WriteEntry(const Key& key, Operator op, const Node& value, uint depth);
+            void WriteComment(std::string_view comment);
+
+            std::string_view GetContent() const;
+            void Flush();
+
+        private:
+            void WriteEntries(const Node& node, uint depth);
+            void WriteValue(const Node& value, uint depth);
+            void WriteRaw(const RawValue& value);
+            void WriteKey(const Key& key);
+            void WriteNumber(double number);
+            void WriteRangesList(const Key& key, const IntervalList& list, uint depth);
+            void WriteIndent(uint depth);
+
+        private:
+            std::ostream* m_Stream;
+            std::string m_Buffer;
+    };
+}
+
+///////////////////////////////////////////
+//          Formatters for fmt           //
+///////////////////////////////////////////
+template <>
+class fmt::formatter<Parser::Node> {
+public:
+    constexpr auto parse(format_parse_context& ctx) {
+        return ctx.begin();
+    }
+
+    template <typename Context>
+    auto format(const Parser::Node& node, Context& ctx) const -> decltype(ctx.out()) {
+        Parser::Writer writer;
+        writer.Write(node);
+
+        // Unlike files, formatted nodes don't end with a new line.
+        std::string_view content = writer.GetContent();
+        if(content.ends_with('\n'))
+            content.remove_suffix(1);
+        return std::copy(content.begin(), content.end(), ctx.out());
+    }
+};
@@ -20,9 +20,12 @@
 #include "util/String.hpp"
 #include "util/Math.hpp"
 #include "util/File.hpp"
+#include "util/Parallel.hpp"
 #include "util/Color.hpp"
 #include "util/Date.hpp"
 #include "util/ScopedString.hpp"
+#include "util/Symbol.hpp"
+#include "util/IntervalList.hpp"
 #include "app/Configuration.hpp"
 
 #include "app/map/TitleType.hpp"
@@ -36,14 +39,17 @@ class SignalHandler;
 class App;
 
 namespace Parser {
-    class Token;
     class Node;
-    class AbstractValueHolder;
     class NodeHolder;
-    class LeafHolder;
+    class Arena;
+    class Document;
+    struct Patch;
+    struct Source;
 }
 
 class Mod;
+class TitlesLoader;
+class ProvincesHistoryLoader;
 class Province;
 class Title;
 class HighTitle;
@@ -9,7 +9,7 @@ struct Date {
 
     Date(int y, int m, int d) : year(y), month(m), day(d) {}
 
-    Date(const std::string& str) {
+    explicit Date(const std::string& str) {
         std::vector<std::string> result = String::Split(str, ".");
         year = std::stoi(result[0]);
         month = std::stoi(result[1]);
@@ -43,6 +43,13 @@ struct Date {
     }
 };
 
+template <>
+struct std::hash<Date> {
+    std::size_t operator()(const Date& date) const {
+        return std::hash<int>()((date.year << 9) | (date.month << 5) | date.day);
+    }
+};
+
 template <>
 class fmt::formatter<Date> {
 public:
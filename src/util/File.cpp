@@ -1,5 +1,9 @@
 #include "File.hpp"
 #include <filesystem>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 std::set<std::string> File::ListFiles(const std::string& dirPath) {
     std::set<std::string> files;
@@ -39,4 +43,46 @@ std::vector<std::vector<std::string>> File::ReadCSV(const std::string& filePath)
     file.close();
     
     return lines;
-}
\ No newline at end of file
+}
+
+File::MappedFile::MappedFile(const std::string& filePath)
+: m_Descriptor(-1), m_Data(nullptr), m_Size(0) {
+    m_Descriptor = open(filePath.c_str(), O_RDONLY);
+    if(m_Descriptor < 0)
+        return;
+
+    struct stat info;
+    if(fstat(m_Descriptor, &info) < 0 || info.st_size == 0)
+        return;
+
+    void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, m_Descriptor, 0);
+    if(data == MAP_FAILED)
+        return;
+
+    // The files are always read from the beginning to the end.
+    madvise(data, info.st_size, MADV_SEQUENTIAL);
+
+    m_Data = data;
+    m_Size = info.st_size;
+}
+
+File::MappedFile::~MappedFile() {
+    if(m_Data != nullptr)
+        munmap(m_Data, m_Size);
+    if(m_Descriptor >= 0)
+        close(m_Descriptor);
+}
+
+bool File::MappedFile::IsOpen() const {
+    return m_Descriptor >= 0;
+}
+
+std::size_t File::MappedFile::GetSize() const {
+    return m_Size;
+}
+
+std::string_view File::MappedFile::GetContent() const {
+    if(m_Data == nullptr)
+        return std::string_view();
+    return std::string_view((const char*) m_Data, m_Size);
+}
@@ -5,4 +5,24 @@ namespace File {
     
     std::string ReadString(std::ifstream& file);
     std::vector<std::vector<std::string>> ReadCSV(const std::string& filePath);
-}
\ No newline at end of file
+
+    // Read-only memory mapping of a whole file. The content is only
+    // valid as long as the MappedFile object is alive.
+    class MappedFile {
+    public:
+        MappedFile(const std::string& filePath);
+        MappedFile(const MappedFile&) = delete;
+        ~MappedFile();
+
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool IsOpen() const;
+        std::size_t GetSize() const;
+        std::string_view GetContent() const;
+
+    private:
+        int m_Descriptor;
+        void* m_Data;
+        std::size_t m_Size;
+    };
+}
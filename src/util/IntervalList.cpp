@@ -0,0 +1,113 @@
+#include "IntervalList.hpp"
+
+////////////////////////////////
+//       Iterator class       //
+////////////////////////////////
+
+IntervalList::Iterator::Iterator(const std::vector<Interval>* intervals, std::size_t index)
+: m_Intervals(intervals), m_Index(index), m_Value(index < intervals->size() ? (*intervals)[index].first : 0) {}
+
+int32_t IntervalList::Iterator::operator*() const {
+    return m_Value;
+}
+
+IntervalList::Iterator& IntervalList::Iterator::operator++() {
+    if(m_Value < (*m_Intervals)[m_Index].last) {
+        m_Value++;
+        return *this;
+    }
+    m_Index++;
+    m_Value = (m_Index < m_Intervals->size()) ? (*m_Intervals)[m_Index].first : 0;
+    return *this;
+}
+
+IntervalList::Iterator IntervalList::Iterator::operator++(int) {
+    Iterator it = *this;
+    ++(*this);
+    return it;
+}
+
+bool IntervalList::Iterator::operator==(const Iterator& other) const {
+    return m_Index == other.m_Index && m_Value == other.m_Value;
+}
+
+////////////////////////////////
+//     IntervalList class     //
+////////////////////////////////
+
+IntervalList::IntervalList() {}
+
+IntervalList::IntervalList(int32_t first, int32_t last) {
+    this->Add(first, last);
+}
+
+const std::vector<IntervalList::Interval>& IntervalList::GetIntervals() const {
+    return m_Intervals;
+}
+
+bool IntervalList::Empty() const {
+    return m_Intervals.empty();
+}
+
+std::size_t IntervalList::GetSize() const {
+    std::size_t size = 0;
+    for(const Interval& interval : m_Intervals)
+        size += (int64_t) interval.last - interval.first + 1;
+    return size;
+}
+
+bool IntervalList::Contains(int32_t value) const {
+    // First run which doesn't end before the value.
+    auto it = std::lower_bound(m_Intervals.begin(), m_Intervals.end(), value, [](const Interval& interval, int32_t value) {
+        return interval.last < value;
+    });
+    return it != m_Intervals.end() && it->first <= value;
+}
+
+void IntervalList::Add(int32_t value) {
+    this->Add(value, value);
+}
+
+void IntervalList::Add(int32_t first, int32_t last) {
+    if(first > last)
+        std::swap(first, last);
+
+    // Values added in ascending order extend the last run or start a new one.
+    if(m_Intervals.empty() || (int64_t) first > (int64_t) m_Intervals.back().last + 1) {
+        m_Intervals.push_back(Interval{first, last});
+        return;
+    }
+    if(first >= m_Intervals.back().first) {
+        m_Intervals.back().last = std::max(m_Intervals.back().last, last);
+        return;
+    }
+
+    // Otherwise, merge all the runs overlapping or adjacent to the new one.
+    auto begin = std::lower_bound(m_Intervals.begin(), m_Intervals.end(), first, [](const Interval& interval, int32_t value) {
+        return (int64_t) interval.last + 1 < value;
+    });
+    auto end = std::upper_bound(begin, m_Intervals.end(), last, [](int32_t value, const Interval& interval) {
+        return (int64_t) value + 1 < interval.first;
+    });
+
+    if(begin == end) {
+        m_Intervals.insert(begin, Interval{first, last});
+        return;
+    }
+    begin->first = std::min(begin->first, first);
+    begin->last = std::max((end-1)->last, last);
+    m_Intervals.erase(begin+1, end);
+}
+
+void IntervalList::Add(const IntervalList& list) {
+    for(const Interval& interval : list.m_Intervals)
+        this->Add(interval.first, interval.last);
+}
+
+IntervalList::Iterator IntervalList::begin() const {
+    return Iterator(&m_Intervals, 0);
+}
+
+IntervalList::Iterator IntervalList::end() const {
+    return Iterator(&m_Intervals, m_Intervals.size());
+}
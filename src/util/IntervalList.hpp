@@ -0,0 +1,62 @@
+#pragma once
+
+// Sorted set of integers stored as disjoint runs of consecutive values,
+// such as the lists of provinces written with RANGE in default.map.
+// Adding values in ascending order only extends or appends runs.
+class IntervalList {
+public:
+    struct Interval {
+        int32_t first;
+        int32_t last;
+
+        bool operator ==(const Interval& other) const {
+            return first == other.first && last == other.last;
+        }
+    };
+
+    // Iterate over every integer of the runs in ascending order.
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = int32_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const int32_t*;
+        using reference = int32_t;
+
+        Iterator() = default;
+        Iterator(const std::vector<Interval>* intervals, std::size_t index);
+
+        int32_t operator*() const;
+        Iterator& operator++();
+        Iterator operator++(int);
+        bool operator ==(const Iterator& other) const;
+
+    private:
+        const std::vector<Interval>* m_Intervals = nullptr;
+        std::size_t m_Index = 0;
+        int32_t m_Value = 0;
+    };
+
+    IntervalList();
+    IntervalList(int32_t first, int32_t last);
+
+    const std::vector<Interval>& GetIntervals() const;
+    bool Empty() const;
+    // Number of integers, not of runs.
+    std::size_t GetSize() const;
+    bool Contains(int32_t value) const;
+
+    void Add(int32_t value);
+    void Add(int32_t first, int32_t last);
+    void Add(const IntervalList& list);
+
+    Iterator begin() const;
+    Iterator end() const;
+
+    bool operator ==(const IntervalList& other) const {
+        return m_Intervals == other.m_Intervals;
+    }
+
+private:
+    std::vector<Interval> m_Intervals;
+};
@@ -0,0 +1,62 @@
+#include "Parallel.hpp"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+// Set on the threads running the tasks of a Parallel::For.
+static thread_local bool s_IsWorker = false;
+
+uint Parallel::GetThreadsCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void Parallel::For(std::size_t count, const std::function<void(std::size_t)>& function) {
+    if(count == 0)
+        return;
+
+    // A single task is run directly, so that it can still split its own work.
+    if(count == 1) {
+        function(0);
+        return;
+    }
+
+    std::atomic<std::size_t> nextIndex = 0;
+    std::exception_ptr exception = nullptr;
+    std::mutex exceptionMutex;
+
+    auto worker = [&]() {
+        bool wasWorker = s_IsWorker;
+        s_IsWorker = true;
+        std::size_t index;
+        while((index = nextIndex++) < count) {
+            try {
+                function(index);
+            }
+            catch(...) {
+                std::lock_guard lock(exceptionMutex);
+                if(exception == nullptr)
+                    exception = std::current_exception();
+            }
+        }
+        s_IsWorker = wasWorker;
+    };
+
+    // The calling thread takes part in the work too. The tasks of a nested
+    // call are run on the calling thread only, since the other threads
+    // are already busy with the tasks of the outer call.
+    const uint threadsCount = s_IsWorker ? 1 : std::min<std::size_t>(GetThreadsCount(), count);
+    std::vector<UniquePtr<sf::Thread>> threads;
+
+    for(uint i = 1; i < threadsCount; i++) {
+        threads.push_back(MakeUnique<sf::Thread>(worker));
+        threads[threads.size()-1]->launch();
+    }
+
+    worker();
+
+    for(auto& thread : threads)
+        thread->wait();
+
+    if(exception != nullptr)
+        std::rethrow_exception(exception);
+}
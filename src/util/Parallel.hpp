@@ -0,0 +1,14 @@
+#pragma once
+
+namespace Parallel {
+    // Number of threads used to split the work, which is
+    // the number of cores of the machine.
+    uint GetThreadsCount();
+
+    // Call the function for each index in [0, count) from several threads.
+    // Indices are handed out one at a time so that workers taking
+    // longer tasks (such as bigger files) don't hold the others back.
+    // The first exception thrown by a task is rethrown once all threads are done.
+    // Nested calls run their tasks on the calling thread.
+    void For(std::size_t count, const std::function<void(std::size_t)>& function);
+}
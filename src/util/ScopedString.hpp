@@ -31,6 +31,14 @@ struct ScopedString {
     }
 };
 
+template <>
+struct std::hash<ScopedString> {
+    std::size_t operator()(const ScopedString& str) const {
+        std::size_t h = std::hash<std::string>()(str.scope);
+        return h ^ (std::hash<std::string>()(str.value) + 0x9e3779b9 + (h << 6) + (h >> 2));
+    }
+};
+
 template <>
 class fmt::formatter<ScopedString> {
 public:
@@ -0,0 +1,92 @@
+#include "Symbol.hpp"
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+
+// The strings are stored in fixed-size pages which are never moved
+// nor freed, so that a string can be read from its id without locking.
+static constexpr uint32_t PageSize = 4096;
+static constexpr uint32_t MaxPages = 4096;
+
+static std::atomic<std::string*> s_Pages[MaxPages];
+static std::atomic<uint32_t> s_Count = 0;
+
+// The table is created on first use since symbols may
+// be interned during the static initialization.
+struct SymbolTable {
+    std::shared_mutex mutex;
+    std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+static SymbolTable& GetTable() {
+    static SymbolTable table;
+    return table;
+}
+
+static uint32_t Intern(std::string_view str) {
+    // The empty string is always the symbol 0.
+    if(str.empty())
+        return 0;
+
+    SymbolTable& table = GetTable();
+
+    // Most strings are already interned, so first look for
+    // them while allowing other threads to do the same.
+    {
+        std::shared_lock lock(table.mutex);
+        auto it = table.ids.find(str);
+        if(it != table.ids.end())
+            return it->second;
+    }
+
+    std::unique_lock lock(table.mutex);
+    auto it = table.ids.find(str);
+    if(it != table.ids.end())
+        return it->second;
+
+    uint32_t id = std::max<uint32_t>(s_Count.load(std::memory_order_relaxed), 1);
+    uint32_t page = id / PageSize;
+
+    if(page >= MaxPages)
+        throw std::runtime_error("error: too many symbols.");
+    if(s_Pages[page].load(std::memory_order_relaxed) == nullptr)
+        s_Pages[page].store(new std::string[PageSize], std::memory_order_release);
+
+    std::string& stored = s_Pages[page].load(std::memory_order_relaxed)[id % PageSize];
+    stored = str;
+    table.ids[stored] = id;
+    s_Count.store(id + 1, std::memory_order_release);
+
+    return id;
+}
+
+Symbol::Symbol() : m_Id(0) {}
+
+Symbol::Symbol(const char* str) : m_Id(Intern(str)) {}
+
+Symbol::Symbol(const std::string& str) : m_Id(Intern(str)) {}
+
+Symbol::Symbol(std::string_view str) : m_Id(Intern(str)) {}
+
+uint32_t Symbol::GetId() const {
+    return m_Id;
+}
+
+const std::string& Symbol::Str() const {
+    static const std::string empty;
+    if(m_Id == 0)
+        return empty;
+    return s_Pages[m_Id / PageSize].load(std::memory_order_acquire)[m_Id % PageSize];
+}
+
+bool Symbol::Empty() const {
+    return m_Id == 0;
+}
+
+Symbol::operator const std::string&() const {
+    return this->Str();
+}
+
+std::size_t Symbol::GetCount() {
+    return std::max<uint32_t>(s_Count.load(std::memory_order_acquire), 1);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <fmt/format.h>
+
+// Interned string shared by the whole application. Each distinct string
+// is stored once in a global table and symbols only hold its 32-bit id,
+// so they are compared and hashed in constant time.
+// Interning is thread-safe and reading the string back doesn't lock.
+class Symbol {
+public:
+    Symbol();
+    Symbol(const char* str);
+    Symbol(const std::string& str);
+    explicit Symbol(std::string_view str);
+
+    uint32_t GetId() const;
+    const std::string& Str() const;
+    bool Empty() const;
+
+    operator const std::string&() const;
+
+    bool operator ==(const Symbol& other) const {
+        return m_Id == other.m_Id;
+    }
+
+    bool operator !=(const Symbol& other) const {
+        return m_Id != other.m_Id;
+    }
+
+    // Compare the ids, which only gives an arbitrary order:
+    // use LexicalLess to sort symbols by their strings.
+    bool operator <(const Symbol& other) const {
+        return m_Id < other.m_Id;
+    }
+
+    struct LexicalLess {
+        bool operator()(const Symbol& a, const Symbol& b) const {
+            return a.m_Id != b.m_Id && a.Str() < b.Str();
+        }
+    };
+
+    static std::size_t GetCount();
+
+private:
+    uint32_t m_Id;
+};
+
+template <>
+struct std::hash<Symbol> {
+    std::size_t operator()(const Symbol& symbol) const {
+        return std::hash<uint32_t>()(symbol.GetId());
+    }
+};
+
+template <>
+class fmt::formatter<Symbol> {
+public:
+    constexpr auto parse(format_parse_context& ctx) {
+       return ctx.begin();
+    }
+
+    template <typename Context>
+    constexpr auto format(const Symbol& symbol, Context& ctx) const {
+        return format_to(ctx.out(), "{}", symbol.Str());
+    }
+};
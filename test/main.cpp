@@ -0,0 +1,134 @@
+#include "parser/Diagnostics.hpp"
+#include "parser/Parser.hpp"
+
+// Regression tests, run with: make test && ./bin/meckt-test
+// Each test returns false at the first check which fails.
+
+#define CHECK(condition)                                                        \
+    if(!(condition)) {                                                          \
+        fmt::println(stderr, "{}:{}: check failed: {}", __FILE__, __LINE__, #condition); \
+        return false;                                                           \
+    }
+
+static Parser::Node ParseText(std::string_view text) {
+    Parser::TokenStream tokens(text);
+    return Parser::Parse(tokens);
+}
+
+// A copy made while a reference to a nested block is held
+// must not see the modifications made through that reference.
+static bool TestCopyOfExposedNode() {
+    Parser::Node a = ParseText("a = { b = { y = 1 } }");
+    Parser::Node& b = a.Get("a").Get("b");
+    Parser::Node snap = a;
+    b.Put("y", 9.0);
+
+    CHECK((int) snap.Get("a").Get("b").Get("y") == 1);
+    CHECK((int) a.Get("a").Get("b").Get("y") == 9);
+
+    Parser::Node assigned;
+    assigned = a;
+    b.Put("y", 3.0);
+    CHECK((int) assigned.Get("a").Get("b").Get("y") == 9);
+    CHECK((int) snap.Get("a").Get("b").Get("y") == 1);
+    return true;
+}
+
+// Duplicated keys whose values can't be merged are reported,
+// and the first value is kept instead of throwing.
+static bool TestDuplicatedKeysOfAnotherType() {
+    Parser::Diagnostics diagnostics;
+    Parser::Diagnostics::Scope scope(&diagnostics, "test.txt");
+
+    Parser::Node block = ParseText("k = 1\nk = { a = 1 }");
+    CHECK((int) block.Get("k") == 1);
+
+    Parser::Node number = ParseText("j = abc\nj = 2");
+    CHECK((std::string) number.Get("j") == "abc");
+
+    std::vector<Parser::Diagnostic> errors = diagnostics.Get();
+    CHECK(errors.size() == 2);
+    CHECK(errors[0].line == 2 && errors[1].line == 2);
+
+    Parser::Node list = ParseText("k = 1\nk = 2");
+    CHECK(list.Get("k").Is(Parser::ValueType::NUMBER_LIST));
+    CHECK(diagnostics.Get().size() == 2);
+    return true;
+}
+
+// A stray closing brace doesn't end the parsing of the content, and
+// a block still open at the end of the content is reported too.
+static bool TestUnbalancedBraces() {
+    Parser::Diagnostics diagnostics;
+    Parser::Diagnostics::Scope scope(&diagnostics, "test.txt");
+
+    Parser::Node stray = ParseText("a = 1\n}\nb = 2");
+    CHECK(stray.ContainsKey("b"));
+
+    Parser::Node unclosed = ParseText("a = { b = 1\n");
+    CHECK((int) unclosed.Get("a").Get("b") == 1);
+
+    std::vector<Parser::Diagnostic> errors = diagnostics.Get();
+    CHECK(errors.size() == 2);
+    CHECK(errors[0].line == 1 && errors[1].line == 2);
+    return true;
+}
+
+// Reading past the end of a stream returns END tokens, and discarding
+// the tokens of a stream lexed from a whole content doesn't change it.
+static bool TestTokenStreamBounds() {
+    std::string content = "a = 1 " + std::string(Parser::TokenStream::ChunkSize, ' ') + "b = 2";
+    Parser::TokenStream tokens(content);
+    for(int i = 0; i < 3; i++)
+        tokens.Next();
+
+    tokens.Discard();
+    CHECK(tokens.GetContent().size() == content.size());
+    CHECK(tokens.GetText(tokens.Peek()) == "b");
+
+    for(int i = 0; i < 3; i++)
+        tokens.Next();
+    CHECK(tokens.Peek().Is(Parser::TokenType::END));
+    CHECK(tokens.Peek(5).Is(Parser::TokenType::END));
+    CHECK(tokens.Next().Is(Parser::TokenType::END));
+    CHECK(tokens.Next().offset == content.size());
+    return true;
+}
+
+// The entries are still found once some of them have been removed
+// from a block which has enough of them to be indexed.
+static bool TestRemoveIndexedEntries() {
+    Parser::Node node = ParseText("");
+    for(int i = 0; i < 40; i++)
+        node.Put((double) i, (double) i * 10);
+    for(int i = 0; i < 40; i += 3)
+        node.Remove((double) i);
+
+    for(int i = 0; i < 40; i++) {
+        CHECK(node.ContainsKey((double) i) == (i % 3 != 0));
+        if(i % 3 != 0)
+            CHECK((int) node.Get((double) i) == i * 10);
+    }
+    node.Put(0.0, 1.0);
+    CHECK((int) node.Get(0.0) == 1);
+    CHECK(node.GetEntries().size() == 27);
+    return true;
+}
+
+int main() {
+    const std::vector<std::pair<const char*, bool(*)()>> tests = {
+        { "copy of exposed node", TestCopyOfExposedNode },
+        { "duplicated keys of another type", TestDuplicatedKeysOfAnotherType },
+        { "unbalanced braces", TestUnbalancedBraces },
+        { "token stream bounds", TestTokenStreamBounds },
+        { "remove indexed entries", TestRemoveIndexedEntries },
+    };
+
+    int failed = 0;
+    for(const auto& [name, test] : tests) {
+        bool passed = test();
+        fmt::println("{} {}", passed ? "PASS" : "FAIL", name);
+        failed += !passed;
+    }
+    return (failed == 0) ? 0 : 1;
+}